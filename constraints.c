@@ -0,0 +1,55 @@
+#include <string.h>
+
+#include "constraints.h"
+
+void Constraints_init(Constraints *constraints) {
+    for (int i = 0; i < WORD_LEN; i++) {
+        constraints->allowed[i] = ~(uint32_t)(0);
+    }
+    memset(constraints->min_count, 0, sizeof(constraints->min_count));
+    memset(constraints->max_count, WORD_LEN, sizeof(constraints->max_count));
+    constraints->counted = 0;
+}
+
+void Constraints_add_probe(Constraints *constraints, PackedWord guess, Pattern pattern) {
+    Pattern colors[WORD_LEN];
+    for (int i = WORD_LEN - 1; i >= 0; i--) {
+        colors[i] = pattern % 3;
+        pattern /= 3;
+    }
+
+    uint8_t colored[1 << PACKED_LETTER_BITS] = {0};
+    uint32_t grayed = 0;
+    uint32_t guessed = 0;
+    for (int i = 0; i < WORD_LEN; i++) {
+        int letter = PackedWord_letter(guess, i);
+        uint32_t bit = 1u << letter;
+        guessed |= bit;
+        if (colors[i] == PATTERN_GREEN) {
+            constraints->allowed[i] &= bit;
+            colored[letter]++;
+            continue;
+        }
+        constraints->allowed[i] &= ~bit;
+        if (colors[i] == PATTERN_GRAY) {
+            grayed |= bit;
+        } else {
+            colored[letter]++;
+            if (grayed & bit) {
+                // yellows go to the leftmost copies of a letter, no word gives a yellow after a gray
+                constraints->allowed[0] = 0;
+            }
+        }
+    }
+
+    for (uint32_t letters = guessed; letters != 0; letters &= letters - 1) {
+        int letter = __builtin_ctz(letters);
+        if (constraints->min_count[letter] < colored[letter]) {
+            constraints->min_count[letter] = colored[letter];
+        }
+        if ((grayed & (1u << letter)) && constraints->max_count[letter] > colored[letter]) {
+            constraints->max_count[letter] = colored[letter];
+        }
+    }
+    constraints->counted |= guessed;
+}
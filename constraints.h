@@ -0,0 +1,43 @@
+#ifndef CONSTRAINTS_H_
+#define CONSTRAINTS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "solver.h"
+#include "pattern.h"
+
+// letters a word must have to give the same results as the probes,
+// letter sets are bit masks indexed by the 5 bit packed letter
+typedef struct {
+    uint32_t allowed[WORD_LEN];
+    uint8_t min_count[1 << PACKED_LETTER_BITS];
+    uint8_t max_count[1 << PACKED_LETTER_BITS];
+    uint32_t counted; // letters with a min or max count
+} Constraints;
+
+void Constraints_init(Constraints *constraints);
+void Constraints_add_probe(Constraints *constraints, PackedWord guess, Pattern pattern);
+
+static inline bool Constraints_match(const Constraints *constraints, PackedWord word) {
+    uint32_t misplaced = 0;
+    for (int i = 0; i < WORD_LEN; i++) {
+        misplaced |= (1u << PackedWord_letter(word, i)) & ~constraints->allowed[i];
+    }
+    if (misplaced != 0) {
+        return false;
+    }
+    for (uint32_t letters = constraints->counted; letters != 0; letters &= letters - 1) {
+        int letter = __builtin_ctz(letters);
+        int count = 0;
+        for (int i = 0; i < WORD_LEN; i++) {
+            count += PackedWord_letter(word, i) == letter;
+        }
+        if (count < constraints->min_count[letter] || count > constraints->max_count[letter]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif //CONSTRAINTS_H_
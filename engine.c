@@ -0,0 +1,1537 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "solver.h"
+#include "engine.h"
+#include "pattern.h"
+#include "kernels.h"
+#include "constraints.h"
+#include "histogram.h"
+#include "ranking.h"
+#include "partition.h"
+#include "pool.h"
+#include "tree.h"
+#include "words.c"
+
+#ifdef DEBUG
+#define LOG_DEBUG(...) solver_printf(__VA_ARGS__)
+#else
+#define LOG_DEBUG(...)
+#endif
+
+// one game; everything else is shared by all contexts and read only once initialized
+struct SolverContext {
+    PackedWord probe_words[MAX_PROBES];
+    WordIndex probe_guesses[MAX_PROBES];
+    Pattern probe_patterns[MAX_PROBES];
+    uint32_t probes_count;
+    bool uses_workers;              // false scores on the calling thread, for playing many games at once
+
+    WordIndex *candidates;          // possible answers, allocated to fit
+    size_t candidates_count;
+    size_t candidates_probes_count; // probes already applied to candidates, 0 when they are stale
+
+    WordIndex best_guesses[TOP_GUESSES_CAPACITY]; // of the previous turn
+    size_t best_guesses_count;
+};
+
+
+static PatternMatrix MATRIX = {0};
+static const Kernels *KERNELS = NULL;
+static PackedWord PACKED_WORDS[WORDS_COUNT];
+static uint32_t LETTER_MASKS[WORDS_COUNT];
+static WordIndex WORDS_BY_PACKED[WORDS_COUNT]; // the dictionary is two sorted runs, guesses then answers
+static pthread_once_t DICTIONARY_ONCE = PTHREAD_ONCE_INIT;
+
+static int compare_packed_words(const void *a, const void *b) {
+    PackedWord word_a = PACKED_WORDS[*(const WordIndex*) a], word_b = PACKED_WORDS[*(const WordIndex*) b];
+    return (word_a > word_b) - (word_a < word_b);
+}
+
+static void init_dictionary(void) {
+    for (size_t i = 0; i < WORDS_COUNT; i++) {
+        PACKED_WORDS[i] = Word_pack(WORDS[i]);
+        LETTER_MASKS[i] = PackedWord_letters(PACKED_WORDS[i]);
+        WORDS_BY_PACKED[i] = i;
+    }
+    qsort(WORDS_BY_PACKED, WORDS_COUNT, sizeof(WordIndex), compare_packed_words);
+}
+
+static void init_matrix(void) {
+    KERNELS = get_kernels();
+    solver_printf("Kernels: %s\n", KERNELS->name);
+    PatternMatrix_open(&MATRIX, WORDS, WORDS_COUNT);
+}
+
+static WordIndex find_packed_word_index(PackedWord word) {
+    pthread_once(&DICTIONARY_ONCE, init_dictionary);
+    size_t from = 0, to = WORDS_COUNT;
+    while (from < to) {
+        size_t middle = from + (to - from) / 2;
+        if (PACKED_WORDS[WORDS_BY_PACKED[middle]] < word) {
+            from = middle + 1;
+        } else {
+            to = middle;
+        }
+    }
+    if (from == WORDS_COUNT || PACKED_WORDS[WORDS_BY_PACKED[from]] != word) return NO_WORD_INDEX;
+    return WORDS_BY_PACKED[from];
+}
+
+WordIndex find_word_index(Word word) {
+    return find_packed_word_index(Word_pack(word));
+}
+
+static size_t filter_words(const SolverContext *context, WordIndex *restrict dst, size_t word_from, size_t word_to) {
+    Constraints constraints;
+    Constraints_init(&constraints);
+    for (size_t probe_i = 0; probe_i < context->probes_count; probe_i++) {
+        Constraints_add_probe(&constraints, context->probe_words[probe_i], context->probe_patterns[probe_i]);
+    }
+
+    size_t count = 0;
+    for (WordIndex w = word_from; w < word_to; w++) {
+        dst[count] = w;
+        count += Constraints_match(&constraints, PACKED_WORDS[w]);
+    }
+    return count;
+}
+
+// keeps the words of src (dst may be src) that give the same result for a single probe
+static size_t filter_by_probe(const SolverContext *context, WordIndex *dst, const WordIndex *src, size_t count,
+                              size_t probe_index) {
+    WordIndex guess = context->probe_guesses[probe_index];
+    Pattern pattern = context->probe_patterns[probe_index];
+    if (guess != NO_WORD_INDEX) {
+        return KERNELS->filter(PatternMatrix_row(&MATRIX, guess), pattern, src, count, dst);
+    }
+
+    Constraints constraints;
+    Constraints_init(&constraints);
+    Constraints_add_probe(&constraints, context->probe_words[probe_index], pattern);
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        dst[kept] = src[i];
+        kept += Constraints_match(&constraints, PACKED_WORDS[src[i]]);
+    }
+    return kept;
+}
+
+
+
+// THREADING STUFF
+// guesses are claimed in chunks this big
+#define SCORE_CHUNK 64
+
+// fewer candidates than this are filtered on the calling thread
+#define PARALLEL_FILTER_MIN 2048
+
+typedef struct {
+    TopGuesses top;
+    size_t chunks_count;
+    size_t stolen_count;
+    size_t filtered_count;  // candidates kept from the worker's slice
+    size_t filtered_offset; // where they go in the context's candidates
+} WorkerInfo;
+
+// the pool, the queue and everything below serve one guess at a time
+static pthread_mutex_t  POOL_MUTEX              = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t   SHARED_ONCE             = PTHREAD_ONCE_INIT;
+static pthread_once_t   SETTINGS_ONCE           = PTHREAD_ONCE_INIT;
+static pthread_once_t   WORKERS_ONCE            = PTHREAD_ONCE_INIT;
+static WorkerPool       POOL;
+static WorkQueue        QUEUE;
+static WorkerInfo      *WORKERS_INFO = NULL;
+static size_t           REQUESTED_WORKERS = 0; // 0 sizes the pool from the available CPUs
+static bool             PIN_WORKERS = false;
+
+static WordIndex        FILTERED[WORDS_COUNT]; // slices of the candidates being filtered, before compaction
+static size_t           FILTER_COUNT = 0;      // words being filtered: the dictionary or the previous candidates
+
+static void lock_pool(void) {
+    if (pthread_mutex_lock(&POOL_MUTEX) != 0) {
+        fprintf(stderr, "cannot lock mutex\n");
+        exit(-1);
+    }
+}
+
+static void unlock_pool(void) {
+    if (pthread_mutex_unlock(&POOL_MUTEX) != 0) {
+        fprintf(stderr, "cannot unlock mutex\n");
+        exit(-1);
+    }
+}
+
+// candidates only shrink during a game, so a new probe just filters the previous survivors;
+// keeps in order the words [from, to) of whatever is being filtered that match the probes not applied yet
+static size_t filter_range(const SolverContext *context, WordIndex *dst, size_t from, size_t to) {
+    if (context->candidates_probes_count == 0) {
+        return filter_words(context, dst, from, to);
+    }
+    const WordIndex *src = context->candidates + from;
+    size_t count = to - from;
+    for (size_t probe_i = context->candidates_probes_count; probe_i < context->probes_count; probe_i++) {
+        count = filter_by_probe(context, dst, src, count, probe_i);
+        src = dst;
+    }
+    return count;
+}
+
+static void filter_slice(void *arg, size_t worker_index) {
+    const SolverContext *context = arg;
+    size_t from = FILTER_COUNT * worker_index / POOL.workers_count;
+    size_t to = FILTER_COUNT * (worker_index + 1) / POOL.workers_count;
+    WORKERS_INFO[worker_index].filtered_count = filter_range(context, FILTERED + from, from, to);
+}
+
+static void compact_slice(void *arg, size_t worker_index) {
+    SolverContext *context = arg;
+    WorkerInfo *info = WORKERS_INFO + worker_index;
+    size_t from = FILTER_COUNT * worker_index / POOL.workers_count;
+    memcpy(context->candidates + info->filtered_offset, FILTERED + from, info->filtered_count * sizeof(WordIndex));
+}
+
+// one pass over the guesses, scoring them against all candidates or a sample of them
+typedef struct {
+    const WordIndex *guesses;    // NULL for the whole dictionary
+    size_t guesses_count;
+    const WordIndex *candidates;
+    size_t candidates_count;
+    _Atomic uint64_t bound;      // see tighten_bound(), UINT64_MAX unless the solver is bounded
+    uint64_t *scores;            // score or partition signature of every guess of the dictionary, for passes over all
+} ScoringPass;
+
+// a guess scoring more than the last of a full top list cannot make the best guesses of the turn,
+// so every worker lowers the shared bound to its own last top guess and skips guesses going past it
+static uint64_t tighten_bound(const TopGuesses *top, _Atomic uint64_t *bound) {
+    uint64_t shared = atomic_load_explicit(bound, memory_order_relaxed);
+    if (top->count < TOP_GUESSES_CAPACITY) return shared;
+    uint64_t own = top->guesses[TOP_GUESSES_CAPACITY - 1].score;
+    while (own < shared && !atomic_compare_exchange_weak_explicit(bound, &shared, own,
+                                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+    return own < shared ? own : shared;
+}
+
+static void score_chunk(ScoringPass *pass, TopGuesses *top, size_t from, size_t to) {
+    for (size_t i = from; i < to; i++) {
+        WordIndex guess = pass->guesses != NULL ? pass->guesses[i] : i;
+        Histogram histogram;
+        uint64_t score;
+        if (!SOLVER_KIND.is_bounded) {
+            Histogram_build(&histogram, &MATRIX, guess, pass->candidates, pass->candidates_count);
+            score = SOLVER_KIND.score_histogram(&histogram);
+        } else if (!Histogram_build_bounded(&histogram, &MATRIX, guess, pass->candidates, pass->candidates_count,
+                                            tighten_bound(top, &pass->bound), &score)) {
+            continue;
+        }
+        TopGuesses_add(top, (RankedGuess) {
+            .word = guess,
+            .is_candidate = histogram.counts[PATTERN_ALL_GREEN] > 0,
+            .score = score,
+        });
+    }
+}
+
+static bool is_best_guess(const SolverContext *context, WordIndex word) {
+    for (size_t i = 0; i < context->best_guesses_count; i++) {
+        if (context->best_guesses[i] == word) return true;
+    }
+    return false;
+}
+
+// the best guesses of the previous turn and the first candidates are likely good again,
+// so they are scored up front and the last of their top list is the first bound
+static uint64_t initial_bound(const SolverContext *context) {
+    if (!SOLVER_KIND.is_bounded) return UINT64_MAX;
+    TopGuesses seeds;
+    TopGuesses_clear(&seeds, SOLVER_KIND.order);
+    size_t candidate_seeds = context->candidates_count < TOP_GUESSES_CAPACITY ? context->candidates_count : TOP_GUESSES_CAPACITY;
+    for (size_t i = 0; i < context->best_guesses_count + candidate_seeds; i++) {
+        WordIndex guess;
+        if (i < context->best_guesses_count) {
+            guess = context->best_guesses[i];
+        } else {
+            guess = context->candidates[i - context->best_guesses_count];
+            if (is_best_guess(context, guess)) continue; // a guess counted twice would make the bound too tight
+        }
+        Histogram histogram;
+        Histogram_build(&histogram, &MATRIX, guess, context->candidates, context->candidates_count);
+        TopGuesses_add(&seeds, (RankedGuess) {
+            .word = guess,
+            .score = SOLVER_KIND.score_histogram(&histogram),
+        });
+    }
+    return seeds.count == TOP_GUESSES_CAPACITY ? seeds.guesses[TOP_GUESSES_CAPACITY - 1].score : UINT64_MAX;
+}
+
+static void sample_chunk(ScoringPass *pass, size_t from, size_t to) {
+    for (size_t guess_i = from; guess_i < to; guess_i++) {
+        Histogram histogram;
+        Histogram_build(&histogram, &MATRIX, guess_i, pass->candidates, pass->candidates_count);
+        pass->scores[guess_i] = SOLVER_KIND.score_histogram(&histogram);
+    }
+}
+
+static void sign_chunk(ScoringPass *pass, size_t from, size_t to) {
+    for (size_t i = from; i < to; i++) {
+        WordIndex guess = pass->guesses != NULL ? pass->guesses[i] : i;
+        pass->scores[guess] = Partition_signature(&MATRIX, guess, pass->candidates, pass->candidates_count);
+    }
+}
+
+static void score_guesses(void *arg, size_t worker_index) {
+    ScoringPass *pass = arg;
+    WorkerInfo* info = WORKERS_INFO + worker_index;
+    LOG_DEBUG("score_guesses(#%02zu) starting work\n", worker_index);
+    TopGuesses_clear(&info->top, SOLVER_KIND.order);
+    info->chunks_count = 0;
+    info->stolen_count = 0;
+    size_t guess_from, guess_to;
+    bool stolen;
+    while (WorkQueue_claim(&QUEUE, worker_index, &guess_from, &guess_to, &stolen)) {
+        info->chunks_count++;
+        info->stolen_count += stolen;
+        score_chunk(pass, &info->top, guess_from, guess_to);
+    }
+}
+
+static void sample_guesses(void *arg, size_t worker_index) {
+    ScoringPass *pass = arg;
+    size_t guess_from, guess_to;
+    bool stolen;
+    while (WorkQueue_claim(&QUEUE, worker_index, &guess_from, &guess_to, &stolen)) {
+        sample_chunk(pass, guess_from, guess_to);
+    }
+}
+
+static void sign_guesses(void *arg, size_t worker_index) {
+    ScoringPass *pass = arg;
+    size_t guess_from, guess_to;
+    bool stolen;
+    while (WorkQueue_claim(&QUEUE, worker_index, &guess_from, &guess_to, &stolen)) {
+        sign_chunk(pass, guess_from, guess_to);
+    }
+}
+
+static void init_workers(void) {
+    WorkerPool_init(&POOL, REQUESTED_WORKERS, PIN_WORKERS);
+    LOG_DEBUG("init_workers() workers_count = %zu\n", POOL.workers_count);
+    WorkQueue_init(&QUEUE, POOL.workers_count);
+    WORKERS_INFO = calloc(POOL.workers_count, sizeof(WorkerInfo));
+    if (WORKERS_INFO == NULL) {
+        fprintf(stderr, "cannot allocate workers info\n");
+        exit(-1);
+    }
+}
+// THREADING STUFF END
+
+
+
+static void resize_candidates(SolverContext *context, size_t count) {
+    WordIndex *candidates = realloc(context->candidates, (count > 0 ? count : 1) * sizeof(WordIndex));
+    if (candidates == NULL) {
+        fprintf(stderr, "cannot allocate candidates\n");
+        exit(-1);
+    }
+    context->candidates = candidates;
+    context->candidates_count = count;
+}
+
+// a full filter starts from the whole dictionary, so the candidates are grown first and shrunk after
+static void filter_candidates(SolverContext *context) {
+    if (context->candidates_probes_count == 0) {
+        resize_candidates(context, WORDS_COUNT);
+    }
+    resize_candidates(context, filter_range(context, context->candidates, 0, context->candidates_count));
+}
+
+// every worker filters a slice, then the slices are moved together in order; needs the pool lock
+static void filter_candidates_on_workers(SolverContext *context) {
+    FILTER_COUNT = context->candidates_probes_count == 0 ? WORDS_COUNT : context->candidates_count;
+    if (FILTER_COUNT < PARALLEL_FILTER_MIN || POOL.workers_count == 1) {
+        filter_candidates(context);
+        return;
+    }
+    WorkerPool_run(&POOL, filter_slice, context);
+    size_t count = 0;
+    for (size_t i = 0; i < POOL.workers_count; i++) {
+        WORKERS_INFO[i].filtered_offset = count;
+        count += WORKERS_INFO[i].filtered_count;
+    }
+    resize_candidates(context, count);
+    WorkerPool_run(&POOL, compact_slice, context);
+}
+
+static void rank_guesses(const SolverContext *context, ScoringPass *pass, TopGuesses *top) {
+    TopGuesses_clear(top, SOLVER_KIND.order);
+    if (!context->uses_workers) {
+        score_chunk(pass, top, 0, pass->guesses_count);
+        return;
+    }
+    WorkQueue_reset(&QUEUE, pass->guesses_count, SCORE_CHUNK);
+    WorkerPool_run(&POOL, score_guesses, pass);
+    LOG_DEBUG("guess_word() merging top guesses\n");
+    for (size_t i = 0; i < POOL.workers_count; i++) {
+        TopGuesses_merge(top, &WORKERS_INFO[i].top);
+    }
+}
+
+static void sample_scores(const SolverContext *context, ScoringPass *pass) {
+    if (!context->uses_workers) {
+        sample_chunk(pass, 0, WORDS_COUNT);
+        return;
+    }
+    WorkQueue_reset(&QUEUE, WORDS_COUNT, SCORE_CHUNK);
+    WorkerPool_run(&POOL, sample_guesses, pass);
+}
+
+static void sign_partitions(const SolverContext *context, ScoringPass *pass) {
+    if (!context->uses_workers) {
+        sign_chunk(pass, 0, pass->guesses_count);
+        return;
+    }
+    WorkQueue_reset(&QUEUE, pass->guesses_count, SCORE_CHUNK);
+    WorkerPool_run(&POOL, sign_guesses, pass);
+}
+
+static void* checked_malloc(size_t size) {
+    void *memory = malloc(size);
+    if (memory == NULL) {
+        fprintf(stderr, "cannot allocate scoring buffers\n");
+        exit(-1);
+    }
+    return memory;
+}
+
+// whether a guess is a candidate is known exactly, only the scores are estimates
+static bool* mark_candidates(const SolverContext *context) {
+    bool *is_candidate = checked_malloc(WORDS_COUNT * sizeof(bool));
+    memset(is_candidate, 0, WORDS_COUNT * sizeof(bool));
+    for (size_t i = 0; i < context->candidates_count; i++) {
+        is_candidate[context->candidates[i]] = true;
+    }
+    return is_candidate;
+}
+
+
+
+// PRESCREENING
+// every guess is scored on a random sample of the candidates first, only the best of them on all candidates
+static size_t PRESCREEN_SAMPLE = 0; // candidates in the sample, 0 scores every guess on all candidates
+static double PRESCREEN_KEEP = 0.05;
+static double PRESCREEN_MARGIN = 0.1;
+static bool PRESCREEN_CHECK = false;
+static bool IS_PRESCREENING_SET = false;
+static _Atomic size_t PRESCREENED_TURNS = 0;
+static _Atomic size_t CHANGED_PICKS = 0;
+
+// "sample[,keep[,margin]]", e.g. "500,0.05,0.1"
+#define PRESCREEN_ENV "SOLVER_PRESCREEN"
+// any value also scores every guess exactly to count the turns in which the sample changed the pick
+#define PRESCREEN_CHECK_ENV "SOLVER_PRESCREEN_CHECK"
+
+// written so that NaN fails too
+static bool are_prescreening_fractions_valid(double keep, double margin) {
+    return keep > 0 && keep <= 1 && margin >= 0;
+}
+
+static void init_prescreening(void) {
+    if (IS_PRESCREENING_SET) return;
+    const char *value = getenv(PRESCREEN_ENV);
+    if (value != NULL) {
+        size_t sample = 0;
+        double keep = PRESCREEN_KEEP, margin = PRESCREEN_MARGIN;
+        if (sscanf(value, "%zu,%lf,%lf", &sample, &keep, &margin) < 1) {
+            fprintf(stderr, "%s=%s is not sample[,keep[,margin]], ignoring it\n", PRESCREEN_ENV, value);
+        } else if (!are_prescreening_fractions_valid(keep, margin)) {
+            fprintf(stderr, "%s=%s needs keep in (0, 1] and margin >= 0, ignoring it\n", PRESCREEN_ENV, value);
+            return;
+        }
+        set_prescreening(sample, keep, margin, getenv(PRESCREEN_CHECK_ENV) != NULL);
+    }
+}
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// fills kept with the guesses worth scoring on all candidates, in dictionary order
+static size_t prescreen(const SolverContext *context, WordIndex *kept) {
+    // the sample is random but the same for the same candidates, so games can be replayed
+    size_t n = context->candidates_count;
+    WordIndex *sample = checked_malloc(n * sizeof(WordIndex));
+    memcpy(sample, context->candidates, n * sizeof(WordIndex));
+    uint64_t state = n * 0x100000001b3ULL ^ sample[0] ^ (uint64_t) sample[n - 1] << 32;
+    for (size_t i = 0; i < PRESCREEN_SAMPLE; i++) {
+        size_t j = i + splitmix64(&state) % (n - i);
+        WordIndex swap = sample[i];
+        sample[i] = sample[j];
+        sample[j] = swap;
+    }
+
+    ScoringPass pass = {
+        .candidates = sample,
+        .candidates_count = PRESCREEN_SAMPLE,
+        .scores = checked_malloc(WORDS_COUNT * sizeof(uint64_t)),
+    };
+    sample_scores(context, &pass);
+
+    bool *is_candidate = mark_candidates(context);
+
+    // the last guess of the kept fraction when ranked by their sample scores
+    size_t keep_count = PRESCREEN_KEEP * WORDS_COUNT;
+    if (keep_count < TOP_GUESSES_CAPACITY) keep_count = TOP_GUESSES_CAPACITY;
+    if (keep_count > WORDS_COUNT) keep_count = WORDS_COUNT;
+    RankedGuess *ranked = checked_malloc(WORDS_COUNT * sizeof(RankedGuess));
+    for (WordIndex g = 0; g < WORDS_COUNT; g++) {
+        ranked[g] = (RankedGuess) { .word = g, .is_candidate = is_candidate[g], .score = pass.scores[g] };
+    }
+    RankedGuess last = RankedGuess_select(SOLVER_KIND.order, ranked, WORDS_COUNT, keep_count - 1);
+
+    // a guess is kept when it would make the fraction with its score lowered by the margin
+    size_t kept_count = 0;
+    for (WordIndex g = 0; g < WORDS_COUNT; g++) {
+        RankedGuess lowered = {
+            .word = g,
+            .is_candidate = is_candidate[g],
+            .score = (uint64_t) (pass.scores[g] / (1.0 + PRESCREEN_MARGIN)),
+        };
+        kept[kept_count] = g;
+        kept_count += !RankedGuess_is_better(SOLVER_KIND.order, last, lowered);
+    }
+    free(ranked);
+    free(is_candidate);
+    free(pass.scores);
+    free(sample);
+    return kept_count;
+}
+
+static void check_prescreened_pick(const SolverContext *context, const TopGuesses *top) {
+    PRESCREENED_TURNS++;
+    if (!PRESCREEN_CHECK) return;
+    ScoringPass pass = {
+        .guesses_count = WORDS_COUNT,
+        .candidates = context->candidates,
+        .candidates_count = context->candidates_count,
+        .bound = initial_bound(context),
+    };
+    TopGuesses exact;
+    rank_guesses(context, &pass, &exact);
+    if (exact.guesses[0].word != top->guesses[0].word) {
+        CHANGED_PICKS++;
+        solver_printf("Prescreening changed the pick from %.*s\n", WORD_LEN, WORDS[exact.guesses[0].word].val);
+    }
+}
+// PRESCREENING END
+
+
+
+// DEDUPLICATION
+// guesses splitting the candidates the same way score the same, so only one guess of each partition is scored;
+// the signatures cost about a scoring pass, which only pays off once few candidates are left
+#define DEDUP_MAX_CANDIDATES 256
+
+static _Atomic size_t DEDUPLICATED_TURNS = 0;
+static _Atomic size_t UNINFORMATIVE_GUESSES = 0; // sharing no letter with the candidates
+static _Atomic size_t COLLAPSED_GUESSES = 0;     // sharing the partition of an earlier informative guess
+
+// a guess sharing no letter with the candidates gets all gray from every one of them, which tells nothing;
+// fills guesses with the others in dictionary order
+static size_t informative_guesses(const SolverContext *context, WordIndex *guesses) {
+    uint32_t letters = 0;
+    for (size_t i = 0; i < context->candidates_count; i++) {
+        letters |= LETTER_MASKS[context->candidates[i]];
+    }
+    size_t count = 0;
+    for (WordIndex g = 0; g < WORDS_COUNT; g++) {
+        guesses[count] = g;
+        count += (LETTER_MASKS[g] & letters) != 0;
+    }
+    if (count == 0) {
+        // results contradicting each other left no candidates, so no guess tells anything: the first stands for all
+        guesses[count++] = 0;
+    }
+    return count;
+}
+
+// keeps one of the informative guesses per partition of the candidates, in dictionary order
+static size_t deduplicate(const SolverContext *context, WordIndex *guesses) {
+    ScoringPass pass = {
+        .guesses = guesses,
+        .guesses_count = informative_guesses(context, guesses),
+        .candidates = context->candidates,
+        .candidates_count = context->candidates_count,
+        .scores = checked_malloc(WORDS_COUNT * sizeof(uint64_t)),
+    };
+    sign_partitions(context, &pass);
+    bool *is_candidate = mark_candidates(context);
+    size_t count = Partition_deduplicate(&MATRIX, guesses, pass.guesses_count, context->candidates,
+                                         context->candidates_count, pass.scores, is_candidate, guesses);
+    free(is_candidate);
+    free(pass.scores);
+    DEDUPLICATED_TURNS++;
+    UNINFORMATIVE_GUESSES += WORDS_COUNT - pass.guesses_count;
+    COLLAPSED_GUESSES += pass.guesses_count - count;
+    return count;
+}
+
+// a possible answer telling all candidates apart scores best under either ranking, and the first of them
+// in dictionary order wins the ties too, so the end game needs no scoring; with up to 2 candidates any one does
+static WordIndex separating_candidate(const WordIndex *candidates, size_t candidates_count) {
+    for (size_t i = 0; i < candidates_count; i++) {
+        if (Partition_separates_all(&MATRIX, candidates[i], candidates, candidates_count)) {
+            return candidates[i];
+        }
+    }
+    return NO_WORD_INDEX;
+}
+// DEDUPLICATION END
+
+
+
+// LOOKAHEAD
+// the best guesses of one ply are ranked again by what two guesses in a row score: every result of the first
+// is split further by its own best follow-up guess; results leaving the same candidates after different
+// first guesses share the follow-up, which is searched only once
+static size_t LOOKAHEAD_TOP = 0;      // best guesses looked into, up to TOP_GUESSES_CAPACITY; 0 turns it off
+static double LOOKAHEAD_BUDGET = 0.0; // seconds per turn, 0 for no limit
+static bool IS_LOOKAHEAD_SET = false;
+
+// "top[,seconds]", e.g. "10,0.5"
+#define LOOKAHEAD_ENV "SOLVER_LOOKAHEAD"
+
+// follow-up guesses claimed at once
+#define LOOKAHEAD_CHUNK 512
+
+// transposition table slots, at least twice the results of all guesses looked into
+#define LOOKAHEAD_SLOTS 8192
+
+typedef struct {
+    WordIndex word;
+    WordIndex *sorted;                      // the candidates by the result they give
+    size_t offsets[PATTERN_COUNT + 1];      // result r leaves sorted[offsets[r] .. offsets[r + 1])
+    uint8_t source[PATTERN_COUNT];          // the guess whose search covers result r, this one or an earlier one
+    Pattern source_result[PATTERN_COUNT];   // and the result there
+    Pattern searched[PATTERN_COUNT];        // results this guess searches the follow-ups of
+    size_t searched_count;
+    uint32_t searched_letters;              // of their candidates
+    _Atomic uint64_t follow_up[PATTERN_COUNT]; // score of the best follow-up guess found so far, per result
+    _Atomic size_t chunks_done;
+} LookaheadGuess;
+
+typedef struct {
+    LookaheadGuess guesses[TOP_GUESSES_CAPACITY];
+    size_t guesses_count;
+    const bool *is_candidate;               // indexed by word
+    size_t chunks_per_guess;
+    _Atomic size_t next_chunk;
+    double deadline; // 0 for none
+} Lookahead;
+
+typedef struct {
+    uint64_t hash;
+    uint8_t guess;
+    Pattern result;
+    bool is_used;
+} LookaheadSlot;
+
+static bool is_lookahead_budget_valid(double budget) {
+    return isfinite(budget) && budget >= 0;
+}
+
+static void init_lookahead(void) {
+    if (IS_LOOKAHEAD_SET) return;
+    const char *value = getenv(LOOKAHEAD_ENV);
+    if (value != NULL) {
+        char *end;
+        long top = strtol(value, &end, 10);
+        double budget = LOOKAHEAD_BUDGET;
+        bool is_parsed = end != value && top >= 0;
+        if (is_parsed && *end == ',') {
+            const char *seconds = end + 1;
+            budget = strtod(seconds, &end);
+            is_parsed = end != seconds;
+        }
+        if (!is_parsed || *end != '\0') {
+            fprintf(stderr, "%s=%s is not top[,seconds], ignoring it\n", LOOKAHEAD_ENV, value);
+            return;
+        }
+        if (!is_lookahead_budget_valid(budget)) {
+            fprintf(stderr, "%s=%s needs seconds finite and >= 0, ignoring it\n", LOOKAHEAD_ENV, value);
+            return;
+        }
+        set_lookahead(top, budget);
+    }
+}
+
+static uint64_t hash_candidates(const WordIndex *candidates, size_t count) {
+    uint64_t hash = count;
+    for (size_t i = 0; i < count; i++) {
+        hash = (hash ^ candidates[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// sorts the candidates of every guess by result and decides who searches which follow-ups:
+// nobody when a candidate left tells the others apart, else the first guess leaving these candidates
+static void plan_lookahead(const SolverContext *context, Lookahead *lookahead, const TopGuesses *top) {
+    LookaheadSlot *slots = calloc(LOOKAHEAD_SLOTS, sizeof(LookaheadSlot));
+    if (slots == NULL) {
+        fprintf(stderr, "cannot allocate lookahead table\n");
+        exit(-1);
+    }
+    for (size_t k = 0; k < lookahead->guesses_count; k++) {
+        LookaheadGuess *guess = lookahead->guesses + k;
+        guess->word = top->guesses[k].word;
+        guess->sorted = checked_malloc(context->candidates_count * sizeof(WordIndex));
+        Partition_sort(&MATRIX, guess->word, context->candidates, context->candidates_count, guess->sorted,
+                       guess->offsets);
+        guess->searched_count = 0;
+        guess->searched_letters = 0;
+        atomic_init(&guess->chunks_done, 0);
+        for (size_t r = 0; r < PATTERN_COUNT; r++) {
+            const WordIndex *left = guess->sorted + guess->offsets[r];
+            size_t count = guess->offsets[r + 1] - guess->offsets[r];
+            guess->source[r] = k;
+            guess->source_result[r] = r;
+            atomic_init(&guess->follow_up[r], UINT64_MAX);
+            if (count == 0) continue;
+            if (separating_candidate(left, count) != NO_WORD_INDEX) {
+                atomic_init(&guess->follow_up[r], (count - 1) * SOLVER_KIND.score_group(1)); // all but itself left alone
+                continue;
+            }
+            uint64_t hash = hash_candidates(left, count);
+            size_t slot = hash & (LOOKAHEAD_SLOTS - 1);
+            for (; slots[slot].is_used; slot = (slot + 1) & (LOOKAHEAD_SLOTS - 1)) {
+                const LookaheadGuess *other = lookahead->guesses + slots[slot].guess;
+                Pattern other_r = slots[slot].result;
+                if (slots[slot].hash == hash && other->offsets[other_r + 1] - other->offsets[other_r] == count
+                    && memcmp(other->sorted + other->offsets[other_r], left, count * sizeof(WordIndex)) == 0) {
+                    break;
+                }
+            }
+            if (slots[slot].is_used) {
+                guess->source[r] = slots[slot].guess;
+                guess->source_result[r] = slots[slot].result;
+                continue;
+            }
+            slots[slot] = (LookaheadSlot) { .hash = hash, .guess = k, .result = r, .is_used = true };
+            guess->searched[guess->searched_count++] = r;
+            for (size_t i = 0; i < count; i++) {
+                guess->searched_letters |= LETTER_MASKS[left[i]];
+            }
+        }
+    }
+    free(slots);
+}
+
+static void search_follow_ups(const Lookahead *lookahead, LookaheadGuess *guess, size_t from, size_t to) {
+    const Pattern *first_row = PatternMatrix_row(&MATRIX, guess->word);
+    uint64_t best[PATTERN_COUNT];
+    for (size_t s = 0; s < guess->searched_count; s++) {
+        best[s] = UINT64_MAX;
+    }
+    uint32_t counts[PATTERN_COUNT] = {0};
+    for (WordIndex follow_up = from; follow_up < to; follow_up++) {
+        // a follow-up sharing no letter with the candidates tells nothing
+        if ((LETTER_MASKS[follow_up] & guess->searched_letters) == 0) continue;
+        const Pattern *row = PatternMatrix_row(&MATRIX, follow_up);
+        for (size_t s = 0; s < guess->searched_count; s++) {
+            // the follow-up is picked the way this solver picks it, so only among the candidates left if it must
+            if (SOLVER_KIND.order == RANK_CANDIDATES_FIRST
+                && (!lookahead->is_candidate[follow_up] || first_row[follow_up] != guess->searched[s])) {
+                continue;
+            }
+            const WordIndex *left = guess->sorted + guess->offsets[guess->searched[s]];
+            size_t count = guess->offsets[guess->searched[s] + 1] - guess->offsets[guess->searched[s]];
+            for (size_t i = 0; i < count; i++) {
+                counts[row[left[i]]]++;
+            }
+            uint64_t score = 0;
+            for (size_t i = 0; i < count; i++) {
+                Pattern pattern = row[left[i]];
+                if (counts[pattern] == 0) continue;
+                // an answer the follow-up hits is not left to guess, or one ply would beat two on immediate wins
+                score += pattern == PATTERN_ALL_GREEN ? 0 : SOLVER_KIND.score_group(counts[pattern]);
+                counts[pattern] = 0;
+            }
+            if (score < best[s]) best[s] = score;
+        }
+    }
+    for (size_t s = 0; s < guess->searched_count; s++) {
+        _Atomic uint64_t *shared = &guess->follow_up[guess->searched[s]];
+        uint64_t current = atomic_load_explicit(shared, memory_order_relaxed);
+        while (best[s] < current && !atomic_compare_exchange_weak_explicit(shared, &current, best[s],
+                                                                          memory_order_relaxed, memory_order_relaxed)) {
+        }
+    }
+}
+
+// the guesses are searched in the order of their one ply rank, so the best of them are done when time runs out
+static void look_ahead_chunks(void *arg, size_t worker_index) {
+    (void) worker_index;
+    Lookahead *lookahead = arg;
+    size_t chunks_count = lookahead->guesses_count * lookahead->chunks_per_guess;
+    size_t chunk;
+    while ((chunk = atomic_fetch_add(&lookahead->next_chunk, 1)) < chunks_count) {
+        if (lookahead->deadline > 0 && seconds_now() > lookahead->deadline) return;
+        LookaheadGuess *guess = lookahead->guesses + chunk / lookahead->chunks_per_guess;
+        size_t from = chunk % lookahead->chunks_per_guess * LOOKAHEAD_CHUNK;
+        size_t to = from + LOOKAHEAD_CHUNK < WORDS_COUNT ? from + LOOKAHEAD_CHUNK : WORDS_COUNT;
+        search_follow_ups(lookahead, guess, from, to);
+        atomic_fetch_add(&guess->chunks_done, 1);
+    }
+}
+
+static bool is_looked_into(const Lookahead *lookahead, size_t k) {
+    const LookaheadGuess *guess = lookahead->guesses + k;
+    for (size_t r = 0; r < PATTERN_COUNT; r++) {
+        if (guess->offsets[r + 1] == guess->offsets[r]) continue;
+        if (lookahead->guesses[guess->source[r]].chunks_done < lookahead->chunks_per_guess) return false;
+    }
+    return true;
+}
+
+// the index in top of the guess scoring best two plies deep, among those searched in time; needs the pool lock
+static size_t look_ahead(const SolverContext *context, const TopGuesses *top) {
+    Lookahead *lookahead = calloc(1, sizeof(Lookahead));
+    if (lookahead == NULL) {
+        fprintf(stderr, "cannot allocate lookahead\n");
+        exit(-1);
+    }
+    lookahead->guesses_count = LOOKAHEAD_TOP < top->count ? LOOKAHEAD_TOP : top->count;
+    lookahead->chunks_per_guess = (WORDS_COUNT + LOOKAHEAD_CHUNK - 1) / LOOKAHEAD_CHUNK;
+    atomic_init(&lookahead->next_chunk, 0);
+    lookahead->deadline = LOOKAHEAD_BUDGET > 0 ? seconds_now() + LOOKAHEAD_BUDGET : 0;
+    bool *is_candidate = mark_candidates(context);
+    lookahead->is_candidate = is_candidate;
+    plan_lookahead(context, lookahead, top);
+    if (context->uses_workers) {
+        WorkerPool_run(&POOL, look_ahead_chunks, lookahead);
+    } else {
+        look_ahead_chunks(lookahead, 0);
+    }
+
+    size_t pick = 0, looked_into = 0;
+    RankedGuess best = {0};
+    for (size_t k = 0; k < lookahead->guesses_count; k++) {
+        const LookaheadGuess *guess = lookahead->guesses + k;
+        if (!is_looked_into(lookahead, k)) continue;
+        RankedGuess ranked = top->guesses[k];
+        ranked.score = 0;
+        for (size_t r = 0; r < PATTERN_COUNT; r++) {
+            if (guess->offsets[r + 1] == guess->offsets[r]) continue;
+            ranked.score += lookahead->guesses[guess->source[r]].follow_up[guess->source_result[r]];
+        }
+        if (looked_into++ == 0 || RankedGuess_is_better(SOLVER_KIND.order, ranked, best)) {
+            pick = k;
+            best = ranked;
+        }
+    }
+    if (looked_into > 0) {
+        solver_printf("Lookahead: %.*s (", WORD_LEN, WORDS[best.word].val);
+        SOLVER_KIND.print_score(best.score, context->candidates_count);
+        solver_printf("), %zu of %zu guesses looked into\n", looked_into, lookahead->guesses_count);
+    } else {
+        solver_printf("Lookahead: out of time\n");
+    }
+    for (size_t k = 0; k < lookahead->guesses_count; k++) {
+        free(lookahead->guesses[k].sorted);
+    }
+    free(is_candidate);
+    free(lookahead);
+    return pick;
+}
+// LOOKAHEAD END
+
+
+
+// END GAME
+// with few candidates left the guess is searched exhaustively for the least guesses to the answer on average;
+// totals over the candidates keep it in integers: a guess costs one for each candidate, plus the totals of
+// the candidates it leaves with each result but all green, which it found
+static size_t ENDGAME_MAX = 0; // candidates at most, 0 turns it off
+static bool IS_ENDGAME_SET = false;
+
+// candidates at most
+#define ENDGAME_ENV "SOLVER_ENDGAME"
+
+// memo slots, kept at most half full, in shards locked apart so that the workers of a search rarely wait
+#define ENDGAME_SLOTS (1 << 20)
+#define ENDGAME_SHARDS 64
+#define ENDGAME_SHARD_SLOTS (ENDGAME_SLOTS / ENDGAME_SHARDS)
+
+typedef struct {
+    uint64_t hash;
+    WordIndex *candidates; // NULL for a free slot
+    size_t count;
+    uint32_t total;        // exact or a lower bound
+    bool is_exact;
+} EndgameSlot;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    EndgameSlot *slots; // allocated on first use
+    size_t count;
+} EndgameShard;
+
+// totals of the candidate sets met by any search, for all contexts, until reset_endgame()
+static EndgameShard   ENDGAME_MEMO[ENDGAME_SHARDS];
+static pthread_once_t ENDGAME_MEMO_ONCE = PTHREAD_ONCE_INIT;
+
+typedef struct {
+    WordIndex guess;
+    uint32_t lower;    // the total with it cannot be less
+    bool is_candidate;
+} EndgameOption;
+
+// the guesses of the root, claimed in order by the workers; every set searched is a subset of its candidates,
+// so their columns of the matrix are copied out to read the results of consecutive guesses sequentially
+typedef struct {
+    const WordIndex *candidates;
+    size_t count;
+    Pattern *columns;    // count columns of WORDS_COUNT results, in the order of the candidates
+    uint16_t *column_of; // index of the column of a candidate word
+    const EndgameOption *options;
+    size_t options_count;
+    _Atomic size_t next_option;
+    _Atomic uint32_t best;
+} EndgameRoot;
+
+static void init_endgame(void) {
+    if (IS_ENDGAME_SET) return;
+    const char *value = getenv(ENDGAME_ENV);
+    if (value != NULL) {
+        char *end;
+        long max_candidates = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || max_candidates < 0) {
+            fprintf(stderr, "%s=%s is not a number of candidates, ignoring it\n", ENDGAME_ENV, value);
+            return;
+        }
+        set_endgame(max_candidates);
+    }
+}
+
+static void init_endgame_memo(void) {
+    for (size_t i = 0; i < ENDGAME_SHARDS; i++) {
+        if (pthread_mutex_init(&ENDGAME_MEMO[i].mutex, NULL) != 0) {
+            fprintf(stderr, "cannot init mutex\n");
+            exit(-1);
+        }
+    }
+}
+
+static EndgameShard* lock_endgame_shard(size_t shard_i) {
+    pthread_once(&ENDGAME_MEMO_ONCE, init_endgame_memo);
+    EndgameShard *shard = ENDGAME_MEMO + shard_i;
+    if (pthread_mutex_lock(&shard->mutex) != 0) {
+        fprintf(stderr, "cannot lock mutex\n");
+        exit(-1);
+    }
+    return shard;
+}
+
+static void unlock_endgame_shard(EndgameShard *shard) {
+    if (pthread_mutex_unlock(&shard->mutex) != 0) {
+        fprintf(stderr, "cannot unlock mutex\n");
+        exit(-1);
+    }
+}
+
+// the low bits of the hash pick the slot, the high ones the shard
+static EndgameShard* lock_endgame(uint64_t hash) {
+    return lock_endgame_shard((hash >> 32) % ENDGAME_SHARDS);
+}
+
+// needs the lock of the shard
+static EndgameSlot* find_endgame_slot(EndgameShard *shard, const WordIndex *candidates, size_t count, uint64_t hash) {
+    if (shard->slots == NULL) {
+        shard->slots = calloc(ENDGAME_SHARD_SLOTS, sizeof(EndgameSlot));
+        if (shard->slots == NULL) {
+            fprintf(stderr, "cannot allocate end game memo\n");
+            exit(-1);
+        }
+    }
+    size_t slot = hash & (ENDGAME_SHARD_SLOTS - 1);
+    for (; shard->slots[slot].candidates != NULL; slot = (slot + 1) & (ENDGAME_SHARD_SLOTS - 1)) {
+        const EndgameSlot *other = shard->slots + slot;
+        if (other->hash == hash && other->count == count
+            && memcmp(other->candidates, candidates, count * sizeof(WordIndex)) == 0) {
+            break;
+        }
+    }
+    return shard->slots + slot;
+}
+
+static bool recall_endgame(const WordIndex *candidates, size_t count, uint64_t hash, uint32_t *total, bool *is_exact) {
+    EndgameShard *shard = lock_endgame(hash);
+    const EndgameSlot *slot = find_endgame_slot(shard, candidates, count, hash);
+    bool is_found = slot->candidates != NULL;
+    if (is_found) {
+        *total = slot->total;
+        *is_exact = slot->is_exact;
+    }
+    unlock_endgame_shard(shard);
+    return is_found;
+}
+
+static void remember_endgame(const WordIndex *candidates, size_t count, uint64_t hash, uint32_t total, bool is_exact) {
+    EndgameShard *shard = lock_endgame(hash);
+    EndgameSlot *slot = find_endgame_slot(shard, candidates, count, hash);
+    if (slot->candidates != NULL) {
+        if (!slot->is_exact && (is_exact || total > slot->total)) {
+            slot->total = total;
+            slot->is_exact = is_exact;
+        }
+    } else if (shard->count < ENDGAME_SHARD_SLOTS / 2) {
+        WordIndex *copy = checked_malloc(count * sizeof(WordIndex));
+        memcpy(copy, candidates, count * sizeof(WordIndex));
+        *slot = (EndgameSlot) { .hash = hash, .candidates = copy, .count = count, .total = total, .is_exact = is_exact };
+        shard->count++;
+    }
+    unlock_endgame_shard(shard);
+}
+
+// a candidate is found in 1 guess at best and every other one in 2: the least total of a set
+static uint32_t endgame_lower_bound(const WordIndex *candidates, size_t count) {
+    return separating_candidate(candidates, count) != NO_WORD_INDEX ? 2 * count - 1 : 2 * count;
+}
+
+// the total after guess cannot be less: a candidate found with it, one per other result found with the next guess
+static bool endgame_option(WordIndex guess, const Pattern **columns, size_t count, EndgameOption *option) {
+    static _Thread_local uint32_t counts[PATTERN_COUNT];
+    uint32_t groups = 0;
+    for (size_t i = 0; i < count; i++) {
+        groups += counts[columns[i][guess]]++ == 0;
+    }
+    bool is_candidate = counts[PATTERN_ALL_GREEN] > 0;
+    groups -= is_candidate;
+    for (size_t i = 0; i < count; i++) {
+        counts[columns[i][guess]] = 0;
+    }
+    if (groups == 1 && !is_candidate) return false; // leaves the same candidates
+    *option = (EndgameOption) {
+        .guess = guess,
+        .lower = count + 2 * (count - is_candidate) - groups,
+        .is_candidate = is_candidate,
+    };
+    return true;
+}
+
+// the guesses splitting the candidates, lowest bound first, those with a lower bound of bound or more left out;
+// the candidates are tried first, and for is_inner a guess reaching 2 * count, where no result leaves more than
+// two candidates so the bound is its total, is the only option: it is the best one of a set needing a search
+static size_t endgame_options(const EndgameRoot *root, const WordIndex *candidates, size_t count, uint32_t bound,
+                              bool is_inner, EndgameOption **options) {
+    uint32_t letters = 0;
+    const Pattern **columns = checked_malloc(count * sizeof(Pattern*));
+    for (size_t i = 0; i < count; i++) {
+        letters |= LETTER_MASKS[candidates[i]];
+        columns[i] = root->columns + (size_t) root->column_of[candidates[i]] * WORDS_COUNT;
+    }
+    size_t options_count = 0, capacity = 64;
+    EndgameOption *found = checked_malloc(capacity * sizeof(EndgameOption));
+    for (size_t i = 0; i < count + WORDS_COUNT; i++) {
+        WordIndex guess = i < count ? candidates[i] : i - count;
+        if ((LETTER_MASKS[guess] & letters) == 0) continue;
+        EndgameOption option;
+        if (!endgame_option(guess, columns, count, &option)) continue;
+        if (i >= count && option.is_candidate) continue; // tried already
+        if (option.lower >= bound) continue;
+        if (is_inner && option.lower == 2 * count) {
+            found[0] = option;
+            options_count = 1;
+            break;
+        }
+        if (options_count == capacity) {
+            capacity *= 2;
+            found = realloc(found, capacity * sizeof(EndgameOption));
+            if (found == NULL) {
+                fprintf(stderr, "cannot allocate end game options\n");
+                exit(-1);
+            }
+        }
+        found[options_count++] = option;
+    }
+    free(columns);
+
+    // bounds are between 2 * count - 1 and 3 * count, counting sort keeps the order among equal ones
+    size_t *offsets = calloc(count + 3, sizeof(size_t));
+    *options = checked_malloc((options_count > 0 ? options_count : 1) * sizeof(EndgameOption));
+    if (offsets == NULL) {
+        fprintf(stderr, "cannot allocate end game options\n");
+        exit(-1);
+    }
+    uint32_t least = 2 * count - 1;
+    for (size_t i = 0; i < options_count; i++) {
+        offsets[found[i].lower - least + 1]++;
+    }
+    for (size_t i = 1; i < count + 3; i++) {
+        offsets[i] += offsets[i - 1];
+    }
+    for (size_t i = 0; i < options_count; i++) {
+        (*options)[offsets[found[i].lower - least]++] = found[i];
+    }
+    free(offsets);
+    free(found);
+    return options_count;
+}
+
+static uint32_t endgame_total(const EndgameRoot *root, const WordIndex *candidates, size_t count, uint32_t bound);
+
+// the total with guess first, or some total of bound or more when it is not less
+static uint32_t endgame_guess_total(const EndgameRoot *root, WordIndex guess, const WordIndex *candidates, size_t count,
+                                    uint32_t bound) {
+    WordIndex *sorted = checked_malloc(count * sizeof(WordIndex));
+    size_t offsets[PATTERN_COUNT + 1];
+    Partition_sort(&MATRIX, guess, candidates, count, sorted, offsets);
+    uint32_t lower[PATTERN_COUNT] = {0};
+    uint32_t rest = 0; // lower bound of the results not searched yet
+    for (size_t r = 0; r < PATTERN_COUNT; r++) {
+        size_t left = offsets[r + 1] - offsets[r];
+        if (left == 0 || r == PATTERN_ALL_GREEN) continue;
+        lower[r] = endgame_lower_bound(sorted + offsets[r], left);
+        rest += lower[r];
+    }
+    uint32_t total = count;
+    for (size_t r = 0; r < PATTERN_COUNT && total + rest < bound; r++) {
+        size_t left = offsets[r + 1] - offsets[r];
+        if (left == 0 || r == PATTERN_ALL_GREEN) continue;
+        rest -= lower[r];
+        total += endgame_total(root, sorted + offsets[r], left, bound - total - rest);
+    }
+    free(sorted);
+    return total + rest;
+}
+
+// the least total for the candidates, or some total of bound or more when it is not less
+static uint32_t endgame_total(const EndgameRoot *root, const WordIndex *candidates, size_t count, uint32_t bound) {
+    uint32_t lower = endgame_lower_bound(candidates, count);
+    if (lower == 2 * count - 1 || lower >= bound) return lower; // a candidate telling the others apart reaches it
+    uint64_t hash = hash_candidates(candidates, count);
+    uint32_t recalled;
+    bool is_exact;
+    if (recall_endgame(candidates, count, hash, &recalled, &is_exact)) {
+        if (is_exact || recalled >= bound) return recalled;
+    }
+
+    EndgameOption *options;
+    size_t options_count = endgame_options(root, candidates, count, bound, true, &options);
+    uint32_t best = bound;
+    for (size_t i = 0; i < options_count && options[i].lower < best; i++) {
+        uint32_t total = endgame_guess_total(root, options[i].guess, candidates, count, best);
+        if (total < best) best = total;
+    }
+    free(options);
+    remember_endgame(candidates, count, hash, best, best < bound);
+    return best;
+}
+
+// every root guess scoring no more than the best so far is searched exactly, so ties are ranked as usual
+static void search_endgame_root(EndgameRoot *root, TopGuesses *top) {
+    TopGuesses_clear(top, RANK_BY_SCORE);
+    size_t i;
+    while ((i = atomic_fetch_add(&root->next_option, 1)) < root->options_count) {
+        EndgameOption option = root->options[i];
+        uint32_t best = atomic_load_explicit(&root->best, memory_order_relaxed);
+        if (option.lower > best) return; // and so are all the next ones
+        uint32_t total = endgame_guess_total(root, option.guess, root->candidates, root->count, best + 1);
+        if (total > best) continue;
+        TopGuesses_add(top, (RankedGuess) { .word = option.guess, .is_candidate = option.is_candidate, .score = total });
+        while (total < best && !atomic_compare_exchange_weak_explicit(&root->best, &best, total,
+                                                                      memory_order_relaxed, memory_order_relaxed)) {
+        }
+    }
+}
+
+static void endgame_root_options(void *arg, size_t worker_index) {
+    search_endgame_root(arg, &WORKERS_INFO[worker_index].top);
+}
+
+// the guess with the least total, a possible answer then the lower word index breaking ties; needs the pool lock
+static RankedGuess endgame_guess(const SolverContext *context) {
+    EndgameRoot root = {
+        .candidates = context->candidates,
+        .count = context->candidates_count,
+        .columns = checked_malloc(context->candidates_count * WORDS_COUNT * sizeof(Pattern)),
+        .column_of = checked_malloc(WORDS_COUNT * sizeof(uint16_t)),
+    };
+    for (size_t i = 0; i < root.count; i++) {
+        root.column_of[root.candidates[i]] = i;
+        for (WordIndex guess = 0; guess < WORDS_COUNT; guess++) {
+            root.columns[i * WORDS_COUNT + guess] = PatternMatrix_get(&MATRIX, guess, root.candidates[i]);
+        }
+    }
+    EndgameOption *options;
+    root.options_count = endgame_options(&root, root.candidates, root.count, UINT32_MAX, false, &options);
+    root.options = options;
+    atomic_init(&root.next_option, 0);
+    atomic_init(&root.best, UINT32_MAX - 1);
+    TopGuesses top;
+    if (context->uses_workers) {
+        WorkerPool_run(&POOL, endgame_root_options, &root);
+        TopGuesses_clear(&top, RANK_BY_SCORE);
+        for (size_t i = 0; i < POOL.workers_count; i++) {
+            TopGuesses_merge(&top, &WORKERS_INFO[i].top);
+        }
+    } else {
+        search_endgame_root(&root, &top);
+    }
+    free(options);
+    free(root.column_of);
+    free(root.columns);
+    return top.guesses[0];
+}
+// END GAME END
+
+
+
+// DECISION TREE
+// every guess is looked up in a tree expanded offline by generate_tree, guesses off the tree are computed
+static const char *TREE_PATH = NULL; // NULL computes every guess
+static bool IS_TREE_SET = false;
+static DecisionTree TREE = {0};
+static bool IS_TREE_LOADED = false;
+static pthread_once_t TREE_ONCE = PTHREAD_ONCE_INIT;
+static _Atomic size_t LOOKED_UP_TURNS = 0;
+static _Atomic size_t MISSED_TURNS = 0;
+
+#define TREE_ENV "SOLVER_TREE"
+
+static void init_tree(void) {
+    if (!IS_TREE_SET) {
+        TREE_PATH = getenv(TREE_ENV);
+    }
+    if (TREE_PATH != NULL) {
+        TreeSettings settings = get_tree_settings();
+        IS_TREE_LOADED = DecisionTree_load(&TREE, TREE_PATH, SOLVER_KIND.name, &settings, WORDS, WORDS_COUNT);
+    }
+}
+
+// the guess of the tree after the probes so far, NO_WORD_INDEX once they left it
+static WordIndex look_up_guess(const SolverContext *context) {
+    uint32_t node = 0;
+    for (uint32_t i = 0; i < context->probes_count; i++) {
+        if (context->probe_guesses[i] != TREE.guesses[node]) return NO_WORD_INDEX;
+        node = DecisionTree_child(&TREE, node, context->probe_patterns[i]);
+        if (node == NO_TREE_NODE) return NO_WORD_INDEX;
+    }
+    return TREE.guesses[node];
+}
+// DECISION TREE END
+
+
+
+// apart from the matrix, so that walking a decision tree never maps or builds it
+static void init_settings(void) {
+    init_prescreening();
+    init_lookahead();
+    init_endgame();
+}
+
+static void init_shared(void) {
+    pthread_once(&DICTIONARY_ONCE, init_dictionary);
+    init_matrix();
+    pthread_once(&SETTINGS_ONCE, init_settings);
+}
+
+const PatternMatrix* get_pattern_matrix(void) {
+    pthread_once(&SHARED_ONCE, init_shared);
+    return &MATRIX;
+}
+
+TreeSettings get_tree_settings(void) {
+    pthread_once(&SETTINGS_ONCE, init_settings);
+    TreeSettings settings = { .endgame_max = ENDGAME_MAX < WORDS_COUNT ? ENDGAME_MAX : WORDS_COUNT };
+    if (PRESCREEN_SAMPLE > 0) {
+        settings.prescreen_sample = PRESCREEN_SAMPLE;
+        settings.prescreen_keep = PRESCREEN_KEEP;
+        settings.prescreen_margin = PRESCREEN_MARGIN;
+    }
+    if (LOOKAHEAD_TOP > 1) {
+        settings.lookahead_top = LOOKAHEAD_TOP;
+        settings.lookahead_budget = LOOKAHEAD_BUDGET;
+    }
+    return settings;
+}
+
+
+static void print_chunks_per_worker(void) {
+    solver_printf("Chunks per worker:");
+    for (size_t i = 0; i < POOL.workers_count; i++) {
+        solver_printf(" %zu", WORKERS_INFO[i].chunks_count);
+        if (WORKERS_INFO[i].stolen_count > 0) {
+            solver_printf("(%zu stolen)", WORKERS_INFO[i].stolen_count);
+        }
+    }
+    solver_printf("\n");
+}
+
+
+
+Word SolverContext_guess_word(SolverContext *context) {
+    pthread_once(&TREE_ONCE, init_tree);
+    if (IS_TREE_LOADED) {
+        WordIndex guess = look_up_guess(context);
+        if (guess != NO_WORD_INDEX) {
+            LOOKED_UP_TURNS++;
+            solver_printf("Decision tree: %.*s\n", WORD_LEN, WORDS[guess].val);
+            return WORDS[guess];
+        }
+        MISSED_TURNS++;
+        solver_printf("Decision tree: off the tree, computing the guess\n");
+    }
+
+    if (context->probes_count == 0) {
+        solver_printf("Possible words: %zu\n", WORDS_COUNT);
+        return Word_from_str(SOLVER_KIND.opener);
+    }
+
+    pthread_once(&SHARED_ONCE, init_shared);
+    // asked again without a new probe, the candidates are filtered already; few of them are filtered on the
+    // calling thread, so the pool is only started and taken once the candidates need scoring
+    bool has_new_probes = context->candidates_probes_count < context->probes_count;
+    bool is_pool_taken = context->uses_workers && has_new_probes
+                         && (context->candidates_probes_count == 0 || context->candidates_count >= PARALLEL_FILTER_MIN);
+    if (is_pool_taken) {
+        pthread_once(&WORKERS_ONCE, init_workers);
+        lock_pool();
+        filter_candidates_on_workers(context);
+    } else if (has_new_probes) {
+        filter_candidates(context);
+    }
+    context->candidates_probes_count = context->probes_count;
+    solver_printf("Possible words: %zu\n", context->candidates_count);
+
+    if (context->candidates_count < 100) {
+        for (size_t i = 0; i < context->candidates_count; i++) {
+            solver_printf("%.*s ", WORD_LEN, WORDS[context->candidates[i]].val);
+        }
+        solver_printf("\n");
+    }
+
+    WordIndex separating = separating_candidate(context->candidates, context->candidates_count);
+    if (separating != NO_WORD_INDEX) {
+        solver_printf("Best guess: %.*s, telling all candidates apart\n", WORD_LEN, WORDS[separating].val);
+        if (is_pool_taken) {
+            unlock_pool();
+        }
+        return WORDS[separating];
+    }
+
+    if (context->uses_workers && !is_pool_taken) {
+        pthread_once(&WORKERS_ONCE, init_workers);
+        lock_pool();
+    }
+
+    if (context->candidates_count > 0 && context->candidates_count <= ENDGAME_MAX) {
+        RankedGuess best = endgame_guess(context);
+        solver_printf("End game: %.*s, %.3f guesses to go on average\n", WORD_LEN, WORDS[best.word].val,
+                      (double) best.score / context->candidates_count);
+        if (context->uses_workers) {
+            unlock_pool();
+        }
+        return WORDS[best.word];
+    }
+
+    ScoringPass pass = {
+        .guesses_count = WORDS_COUNT,
+        .candidates = context->candidates,
+        .candidates_count = context->candidates_count,
+    };
+    WordIndex *guesses = NULL;
+    bool is_prescreened = PRESCREEN_SAMPLE > 0 && context->candidates_count > 2 * PRESCREEN_SAMPLE;
+    if (is_prescreened) {
+        guesses = checked_malloc(WORDS_COUNT * sizeof(WordIndex));
+        pass.guesses = guesses;
+        pass.guesses_count = prescreen(context, guesses);
+        atomic_init(&pass.bound, UINT64_MAX); // the seeds of the bound may not have been kept
+        solver_printf("Prescreening: %zu of %zu guesses kept\n", pass.guesses_count, WORDS_COUNT);
+    } else {
+        if (context->candidates_count <= DEDUP_MAX_CANDIDATES) {
+            guesses = checked_malloc(WORDS_COUNT * sizeof(WordIndex));
+            pass.guesses = guesses;
+            pass.guesses_count = deduplicate(context, guesses);
+            solver_printf("Distinct partitions: %zu of %zu guesses\n", pass.guesses_count, WORDS_COUNT);
+        }
+        // a seed may stand for a partition scored through another guess, which only leaves the top list short
+        atomic_init(&pass.bound, initial_bound(context));
+    }
+    TopGuesses top;
+    rank_guesses(context, &pass, &top);
+    if (is_prescreened) {
+        check_prescreened_pick(context, &top);
+    }
+    free(guesses);
+    context->best_guesses_count = top.count;
+    for (size_t i = 0; i < top.count; i++) {
+        context->best_guesses[i] = top.guesses[i].word;
+    }
+    solver_printf("Best guesses:");
+    for (size_t i = 0; i < top.count; i++) {
+        solver_printf(" %.*s (", WORD_LEN, WORDS[top.guesses[i].word].val);
+        SOLVER_KIND.print_score(top.guesses[i].score, context->candidates_count);
+        solver_printf(")");
+    }
+    solver_printf("\n");
+    size_t pick = 0;
+    if (LOOKAHEAD_TOP > 1 && top.count > 1) {
+        pick = look_ahead(context, &top);
+    }
+    if (context->uses_workers) {
+        print_chunks_per_worker();
+        unlock_pool();
+    }
+    return WORDS[top.guesses[pick].word];
+}
+
+SolverContext* SolverContext_create(bool uses_workers) {
+    SolverContext *context = calloc(1, sizeof(SolverContext));
+    if (context == NULL) {
+        fprintf(stderr, "cannot allocate solver context\n");
+        exit(-1);
+    }
+    context->uses_workers = uses_workers;
+    return context;
+}
+
+void SolverContext_reset(SolverContext *context) {
+    context->probes_count = 0;
+    context->candidates_probes_count = 0;
+    context->best_guesses_count = 0;
+}
+
+void SolverContext_destroy(SolverContext *context) {
+    free(context->candidates);
+    free(context);
+}
+
+void SolverContext_save_probe(SolverContext *context, Probe probe) {
+    uint32_t probe_i = context->probes_count++;
+    context->probe_words[probe_i] = Word_pack(probe.guess);
+    context->probe_guesses[probe_i] = find_packed_word_index(context->probe_words[probe_i]);
+    context->probe_patterns[probe_i] = Pattern_from_result(probe.result);
+}
+
+int SolverContext_get_probes_count(const SolverContext *context) {
+    return context->probes_count;
+}
+
+// not interesting bullshit
+bool is_result_valid(Word result) {
+    for (int i = 0; i < WORD_LEN; i++) {
+        if (result.val[i] != GRAY && result.val[i] != YELLOW && result.val[i] != GREEN) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// the game of the single game API
+static SolverContext DEFAULT_CONTEXT = { .uses_workers = true };
+
+Word guess_word(void) {
+    return SolverContext_guess_word(&DEFAULT_CONTEXT);
+}
+
+void save_probe(Probe probe) {
+    SolverContext_save_probe(&DEFAULT_CONTEXT, probe);
+}
+
+int get_probes_count(void) {
+    return SolverContext_get_probes_count(&DEFAULT_CONTEXT);
+}
+
+void reset_probes(void) {
+    SolverContext_reset(&DEFAULT_CONTEXT);
+}
+
+void set_workers(size_t workers_count, bool pin) {
+    REQUESTED_WORKERS = workers_count;
+    PIN_WORKERS = pin;
+}
+
+void set_prescreening(size_t sample_size, double keep_fraction, double margin, bool check) {
+    if (!are_prescreening_fractions_valid(keep_fraction, margin)) {
+        fprintf(stderr, "prescreening needs keep_fraction in (0, 1] and margin >= 0, ignoring it\n");
+        return;
+    }
+    PRESCREEN_SAMPLE = sample_size;
+    PRESCREEN_KEEP = keep_fraction;
+    PRESCREEN_MARGIN = margin;
+    PRESCREEN_CHECK = check;
+    IS_PRESCREENING_SET = true;
+}
+
+void get_prescreening_stats(size_t *turns, size_t *changed_picks) {
+    *turns = PRESCREENED_TURNS;
+    *changed_picks = CHANGED_PICKS;
+}
+
+void get_deduplication_stats(size_t *turns, size_t *uninformative_guesses, size_t *collapsed_guesses) {
+    *turns = DEDUPLICATED_TURNS;
+    *uninformative_guesses = UNINFORMATIVE_GUESSES;
+    *collapsed_guesses = COLLAPSED_GUESSES;
+}
+
+void set_lookahead(size_t top_count, double budget_seconds) {
+    if (!is_lookahead_budget_valid(budget_seconds)) {
+        fprintf(stderr, "lookahead needs budget_seconds finite and >= 0, ignoring it\n");
+        return;
+    }
+    LOOKAHEAD_TOP = top_count < TOP_GUESSES_CAPACITY ? top_count : TOP_GUESSES_CAPACITY;
+    LOOKAHEAD_BUDGET = budget_seconds;
+    IS_LOOKAHEAD_SET = true;
+}
+
+void set_endgame(size_t max_candidates) {
+    ENDGAME_MAX = max_candidates;
+    IS_ENDGAME_SET = true;
+}
+
+void reset_endgame(void) {
+    for (size_t i = 0; i < ENDGAME_SHARDS; i++) {
+        EndgameShard *shard = lock_endgame_shard(i);
+        if (shard->slots != NULL) {
+            for (size_t slot = 0; slot < ENDGAME_SHARD_SLOTS; slot++) {
+                free(shard->slots[slot].candidates);
+            }
+            free(shard->slots);
+        }
+        shard->slots = NULL;
+        shard->count = 0;
+        unlock_endgame_shard(shard);
+    }
+}
+
+void set_decision_tree(const char *path) {
+    TREE_PATH = path;
+    IS_TREE_SET = true;
+}
+
+void get_decision_tree_stats(size_t *looked_up_turns, size_t *missed_turns) {
+    *looked_up_turns = LOOKED_UP_TURNS;
+    *missed_turns = MISSED_TURNS;
+}
+
+
+bool Word_equals(Word a, Word b) {
+    return memcmp(a.val, b.val, WORD_LEN) == 0;
+}
+
+Word Word_from_str(const char* str) {
+    return *(Word*)str;
+}
+
+int (*solver_printf)(const char *restrict format, ...) = printf;
+
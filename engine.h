@@ -0,0 +1,36 @@
+#ifndef ENGINE_H_
+#define ENGINE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "solver.h"
+#include "histogram.h"
+#include "ranking.h"
+#include "tree.h"
+
+// what tells the solvers apart; engine.c implements solver.h for both of them
+typedef struct {
+    const char *name;  // tells their decision trees apart
+    RankingOrder order;
+    uint64_t (*score_histogram)(const Histogram *histogram);
+    uint64_t (*score_group)(uint32_t count); // what a bucket of count candidates adds to the score
+    const char *opener; // precomputed best first guess
+    bool is_bounded;    // the score is the sum of squares, so scoring a guess can stop once it is past a bound
+    void (*print_score)(uint64_t score, size_t candidates_count);
+} SolverKind;
+
+// defined by the solver linked with the engine: solver.c or solver_entropy.c
+extern const SolverKind SOLVER_KIND;
+
+// the index of word in the dictionary, NO_WORD_INDEX when it is not there
+WordIndex find_word_index(Word word);
+
+// the patterns of every guess against every word, mapped once for all contexts
+const PatternMatrix* get_pattern_matrix(void);
+
+// the settings guesses are chosen with, saved with the decision trees
+TreeSettings get_tree_settings(void);
+
+#endif //ENGINE_H_
@@ -0,0 +1,15 @@
+#include <stdio.h>
+
+#include "solver.h"
+#include "pattern.h"
+#include "kernels.h"
+#include "words.c"
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : PATTERNS_FILE_DEFAULT;
+    PatternMatrix matrix;
+    PatternMatrix_init(&matrix, WORDS, WORDS_COUNT);
+    PatternMatrix_save(&matrix, path, WORDS);
+    printf("%s: %zu words, %s kernels\n", path, WORDS_COUNT, get_kernels()->name);
+    return 0;
+}
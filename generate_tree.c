@@ -0,0 +1,163 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "solver.h"
+#include "pattern.h"
+#include "pool.h"
+#include "partition.h"
+#include "tree.h"
+#include "engine.h"
+#include "words.c"
+
+#define TREE_FILE_DEFAULT "tree.bin"
+
+// the subtree below each result of the opener, built by whichever thread took it
+static Word ROOT_GUESS;
+static WordIndex ROOT_ANSWERS[WORDS_COUNT];
+static size_t ROOT_OFFSETS[PATTERN_COUNT + 1];
+static TreeBuilder SUBTREES[PATTERN_COUNT];
+static uint64_t SUBTREE_GUESSES[PATTERN_COUNT]; // guesses to all answers of the subtree, the opener included
+static _Atomic size_t NEXT_ROOT_PATTERN = 0;
+static bool USES_WORKERS = false;
+
+static int quiet_printf(const char *restrict format, ...) {
+    (void)format;
+    return 0;
+}
+
+static WordIndex guess_index(Word guess) {
+    WordIndex index = find_word_index(guess);
+    if (index == NO_WORD_INDEX) {
+        fprintf(stderr, "the solver guessed %.*s, which is not in the dictionary\n", WORD_LEN, guess.val);
+        exit(-1);
+    }
+    return index;
+}
+
+// adds the node guessed after probes for the answers left, then its subtrees; returns the node
+static uint32_t expand(SolverContext *context, TreeBuilder *builder, Probe *probes, int probes_count,
+                       const WordIndex *answers, size_t count, uint64_t *guesses_total) {
+    if (probes_count >= MAX_PROBES) {
+        fprintf(stderr, "%zu answers still left after %d probes\n", count, MAX_PROBES);
+        exit(-1);
+    }
+    SolverContext_reset(context);
+    for (int i = 0; i < probes_count; i++) {
+        SolverContext_save_probe(context, probes[i]);
+    }
+    Word guess = SolverContext_guess_word(context);
+    WordIndex guess_i = guess_index(guess);
+
+    WordIndex *sorted = malloc(count * sizeof(WordIndex));
+    if (sorted == NULL) {
+        fprintf(stderr, "cannot allocate answers\n");
+        exit(-1);
+    }
+    size_t offsets[PATTERN_COUNT + 1];
+    Partition_sort(get_pattern_matrix(), guess_i, answers, count, sorted, offsets);
+    size_t edges_count = 0;
+    for (size_t p = 0; p < PATTERN_ALL_GREEN; p++) {
+        edges_count += offsets[p + 1] > offsets[p];
+    }
+    *guesses_total += (uint64_t) (probes_count + 1) * (offsets[PATTERN_COUNT] - offsets[PATTERN_ALL_GREEN]);
+
+    uint32_t node = TreeBuilder_add_node(builder, guess_i, edges_count);
+    size_t edge = 0;
+    for (size_t p = 0; p < PATTERN_ALL_GREEN; p++) {
+        size_t from = offsets[p], to = offsets[p + 1];
+        if (from == to) continue;
+        probes[probes_count] = (Probe) { .guess = guess, .result = Pattern_to_result(p) };
+        uint32_t child = expand(context, builder, probes, probes_count + 1, sorted + from, to - from, guesses_total);
+        TreeBuilder_set_edge(builder, node, edge++, p, child);
+    }
+    free(sorted);
+    return node;
+}
+
+static void* expand_routine(void* arg) {
+    (void)arg;
+    SolverContext *context = SolverContext_create(USES_WORKERS);
+    Probe probes[MAX_PROBES];
+    size_t p;
+    while ((p = atomic_fetch_add(&NEXT_ROOT_PATTERN, 1)) < PATTERN_ALL_GREEN) {
+        size_t from = ROOT_OFFSETS[p], to = ROOT_OFFSETS[p + 1];
+        if (from == to) continue;
+        TreeBuilder_init(SUBTREES + p);
+        probes[0] = (Probe) { .guess = ROOT_GUESS, .result = Pattern_to_result(p) };
+        expand(context, SUBTREES + p, probes, 1, ROOT_ANSWERS + from, to - from, SUBTREE_GUESSES + p);
+    }
+    SolverContext_destroy(context);
+    return NULL;
+}
+
+// expands every guess of the solver, with its current settings, into a tree file for set_decision_tree();
+// -j N expands the subtrees below the opener on N threads, -j 0 one per CPU, without it one by one on all workers
+int main(int argc, char **argv) {
+    solver_printf = quiet_printf;
+    set_decision_tree(NULL); // expanding a tree file would only copy it
+    size_t threads_count = 0;
+    int option;
+    while ((option = getopt(argc, argv, "j:")) != -1) {
+        if (option == 'j') {
+            long count = atol(optarg);
+            threads_count = count > 0 ? (size_t) count : available_cpus_count();
+        } else {
+            fprintf(stderr, "usage: %s [-j threads] [tree_file]\n", argv[0]);
+            return -1;
+        }
+    }
+    const char *path = optind < argc ? argv[optind] : TREE_FILE_DEFAULT;
+
+    double started = seconds_now();
+    SolverContext *context = SolverContext_create(false);
+    ROOT_GUESS = SolverContext_guess_word(context);
+    SolverContext_destroy(context);
+    WordIndex root_guess_i = guess_index(ROOT_GUESS);
+    WordIndex all[WORDS_COUNT];
+    for (size_t i = 0; i < WORDS_COUNT; i++) {
+        all[i] = i;
+    }
+    Partition_sort(get_pattern_matrix(), root_guess_i, all, WORDS_COUNT, ROOT_ANSWERS, ROOT_OFFSETS);
+
+    if (threads_count == 0) {
+        USES_WORKERS = true;
+        expand_routine(NULL);
+    } else {
+        pthread_t threads[threads_count];
+        for (size_t i = 0; i < threads_count; i++) {
+            if (pthread_create(threads + i, NULL, expand_routine, NULL) != 0) {
+                fprintf(stderr, "cannot create expanding thread\n");
+                exit(-1);
+            }
+        }
+        for (size_t i = 0; i < threads_count; i++) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    // the opener, then the subtrees in the order of their results
+    TreeBuilder tree;
+    TreeBuilder_init(&tree);
+    size_t edges_count = 0;
+    for (size_t p = 0; p < PATTERN_ALL_GREEN; p++) {
+        edges_count += ROOT_OFFSETS[p + 1] > ROOT_OFFSETS[p];
+    }
+    uint32_t root = TreeBuilder_add_node(&tree, root_guess_i, edges_count);
+    uint64_t guesses_total = ROOT_OFFSETS[PATTERN_COUNT] - ROOT_OFFSETS[PATTERN_ALL_GREEN]; // the opener itself
+    size_t edge = 0;
+    for (size_t p = 0; p < PATTERN_ALL_GREEN; p++) {
+        if (ROOT_OFFSETS[p + 1] == ROOT_OFFSETS[p]) continue;
+        TreeBuilder_set_edge(&tree, root, edge++, p, TreeBuilder_append(&tree, SUBTREES + p));
+        guesses_total += SUBTREE_GUESSES[p];
+        TreeBuilder_free(SUBTREES + p);
+    }
+    TreeSettings settings = get_tree_settings();
+    TreeBuilder_save(&tree, path, SOLVER_KIND.name, &settings, WORDS, WORDS_COUNT);
+    printf("%s: %zu nodes, %.4f guesses per answer on average, expanded in %.1f s\n",
+           path, tree.nodes_count, (double) guesses_total / WORDS_COUNT, seconds_now() - started);
+    TreeBuilder_free(&tree);
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "histogram.h"
+#include "kernels.h"
+
+void Histogram_build(Histogram *histogram, const PatternMatrix *matrix, size_t guess_index,
+                     const WordIndex *candidates, size_t candidates_count) {
+    memset(histogram->counts, 0, sizeof(histogram->counts));
+    get_kernels()->histogram(PatternMatrix_row(matrix, guess_index), candidates, candidates_count, histogram->counts);
+}
+
+uint64_t Histogram_sum_of_squares(const Histogram *histogram) {
+    uint64_t sum = 0;
+    for (int i = 0; i < PATTERN_COUNT; i++) {
+        sum += (uint64_t) histogram->counts[i] * histogram->counts[i];
+    }
+    return sum;
+}
+
+// candidates counted between two checks of the bound
+#define BOUND_CHECK_BLOCK 256
+
+bool Histogram_build_bounded(Histogram *histogram, const PatternMatrix *matrix, size_t guess_index,
+                             const WordIndex *candidates, size_t candidates_count,
+                             uint64_t bound, uint64_t *sum_of_squares) {
+    memset(histogram->counts, 0, sizeof(histogram->counts));
+    const Pattern *row = PatternMatrix_row(matrix, guess_index);
+    uint64_t sum = 0;
+    for (size_t from = 0; from < candidates_count; from += BOUND_CHECK_BLOCK) {
+        size_t to = candidates_count - from < BOUND_CHECK_BLOCK ? candidates_count : from + BOUND_CHECK_BLOCK;
+        for (size_t i = from; i < to; i++) {
+            // (c + 1)^2 - c^2
+            uint32_t *count = &histogram->counts[row[candidates[i]]];
+            sum += 2 * *count + 1;
+            (*count)++;
+        }
+        if (sum > bound) return false;
+    }
+    *sum_of_squares = sum;
+    return true;
+}
+
+
+
+// entropy
+#define C_LOG2_C_TABLE_SIZE (1 << 14)
+#define FIXED_POINT_ONE ((uint64_t)(1) << 32)
+
+static uint64_t C_LOG2_C[C_LOG2_C_TABLE_SIZE];
+static pthread_once_t C_LOG2_C_ONCE = PTHREAD_ONCE_INIT;
+
+// log2(x) in 32.32 fixed point by repeated squaring of the mantissa
+static uint64_t log2_fixed(uint64_t x) {
+    int integer = 63 - __builtin_clzll(x);
+    uint64_t result = (uint64_t) integer << 32;
+    uint64_t mantissa = integer <= 62 ? x << (62 - integer) : x >> 1; // [1, 2) with 62 fraction bits
+    for (uint64_t bit = FIXED_POINT_ONE >> 1; bit != 0; bit >>= 1) {
+        mantissa = (uint64_t) (((unsigned __int128) mantissa * mantissa) >> 62);
+        if (mantissa >= ((uint64_t)(2) << 62)) {
+            mantissa >>= 1;
+            result |= bit;
+        }
+    }
+    return result;
+}
+
+static uint64_t c_log2_c(uint64_t c) {
+    return c <= 1 ? 0 : c * log2_fixed(c);
+}
+
+static void init_c_log2_c(void) {
+    for (uint64_t c = 0; c < C_LOG2_C_TABLE_SIZE; c++) {
+        C_LOG2_C[c] = c_log2_c(c);
+    }
+}
+
+uint64_t Histogram_entropy_score(const Histogram *histogram) {
+    pthread_once(&C_LOG2_C_ONCE, init_c_log2_c);
+    uint64_t sum = 0;
+    for (int i = 0; i < PATTERN_COUNT; i++) {
+        uint32_t count = histogram->counts[i];
+        sum += count < C_LOG2_C_TABLE_SIZE ? C_LOG2_C[count] : c_log2_c(count);
+    }
+    return sum;
+}
+
+uint64_t Histogram_entropy_score_term(uint32_t count) {
+    pthread_once(&C_LOG2_C_ONCE, init_c_log2_c);
+    return count < C_LOG2_C_TABLE_SIZE ? C_LOG2_C[count] : c_log2_c(count);
+}
+
+double entropy_from_score(uint64_t score, size_t candidates_count) {
+    if (candidates_count == 0) return 0.0;
+    return (double) (c_log2_c(candidates_count) - score) / candidates_count / FIXED_POINT_ONE;
+}
+// entropy END
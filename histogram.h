@@ -0,0 +1,39 @@
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pattern.h"
+
+// how the candidates split into results for one guess
+typedef struct {
+    uint32_t counts[PATTERN_COUNT];
+} Histogram;
+
+void Histogram_build(Histogram *histogram, const PatternMatrix *matrix, size_t guess_index,
+                     const WordIndex *candidates, size_t candidates_count);
+
+// sum of the remaining candidates count over all candidates, i.e. the sum of squared bucket sizes
+uint64_t Histogram_sum_of_squares(const Histogram *histogram);
+// what a bucket of count candidates adds to the sum; buckets of disjoint candidates simply add up
+static inline uint64_t Histogram_sum_of_squares_term(uint32_t count) {
+    return (uint64_t) count * count;
+}
+
+// Histogram_build that keeps the sum of squares as it goes and gives up, returning false,
+// as soon as it is past bound; the sum only grows, so such a guess cannot score bound or less
+bool Histogram_build_bounded(Histogram *histogram, const PatternMatrix *matrix, size_t guess_index,
+                             const WordIndex *candidates, size_t candidates_count,
+                             uint64_t bound, uint64_t *sum_of_squares);
+
+// sum of c * log2(c) over the bucket sizes c in 32.32 fixed point, from a table built with integers only;
+// the entropy log2(N) - sum / N for N candidates falls as it grows, so it ranks guesses exactly
+uint64_t Histogram_entropy_score(const Histogram *histogram);
+// what a bucket of count candidates adds to the score, like Histogram_sum_of_squares_term()
+uint64_t Histogram_entropy_score_term(uint32_t count);
+// entropy in bits of a guess with the score above, for output only
+double entropy_from_score(uint64_t score, size_t candidates_count);
+
+#endif //HISTOGRAM_H_
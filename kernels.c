@@ -0,0 +1,294 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kernels.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+static const uint8_t WEIGHTS[WORD_LEN] = { 81, 27, 9, 3, 1 };
+
+
+
+// scalar
+static void generate_patterns_scalar(Word guess, const char *columns, size_t stride, Pattern *dst) {
+    for (size_t j = 0; j < PATTERN_BATCH; j++) {
+        Word actual;
+        for (int i = 0; i < WORD_LEN; i++) {
+            actual.val[i] = columns[i * stride + j];
+        }
+        dst[j] = generate_pattern(guess, actual);
+    }
+}
+
+static size_t filter_patterns_scalar(const Pattern *row, Pattern pattern, const WordIndex *src, size_t count, WordIndex *dst) {
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        WordIndex w = src[i];
+        dst[kept] = w;
+        kept += row[w] == pattern;
+    }
+    return kept;
+}
+
+static void count_patterns_scalar(const Pattern *row, const WordIndex *src, size_t count, uint32_t counts[PATTERN_COUNT]) {
+    for (size_t i = 0; i < count; i++) {
+        counts[row[src[i]]]++;
+    }
+}
+// scalar END
+
+
+
+#ifdef __x86_64__
+// sse2: the avx2 feedback kernel on two 16 byte halves, no gathers so filter and histogram stay scalar
+__attribute__((target("sse2")))
+static void generate_patterns_sse2(Word guess, const char *columns, size_t stride, Pattern *dst) {
+    for (int half = 0; half < PATTERN_BATCH; half += 16) {
+        __m128i actual[WORD_LEN];
+        __m128i not_green[WORD_LEN];
+        __m128i pattern = _mm_setzero_si128();
+        for (int i = 0; i < WORD_LEN; i++) {
+            actual[i] = _mm_loadu_si128((const __m128i*) (columns + i * stride + half));
+            __m128i green = _mm_cmpeq_epi8(actual[i], _mm_set1_epi8(guess.val[i]));
+            not_green[i] = _mm_andnot_si128(green, _mm_set1_epi8(-1));
+            pattern = _mm_add_epi8(pattern, _mm_and_si128(green, _mm_set1_epi8((char) (2 * WEIGHTS[i]))));
+        }
+        for (int i = 0; i < WORD_LEN; i++) {
+            __m128i letter = _mm_set1_epi8(guess.val[i]);
+            __m128i left = _mm_setzero_si128();
+            for (int k = 0; k < WORD_LEN; k++) {
+                left = _mm_add_epi8(left, _mm_and_si128(_mm_cmpeq_epi8(actual[k], letter), not_green[k]));
+            }
+            __m128i taken = _mm_setzero_si128();
+            for (int j = 0; j < i; j++) {
+                if (guess.val[j] == guess.val[i]) {
+                    taken = _mm_add_epi8(taken, not_green[j]);
+                }
+            }
+            __m128i yellow = _mm_and_si128(_mm_cmpgt_epi8(taken, left), not_green[i]);
+            pattern = _mm_add_epi8(pattern, _mm_and_si128(yellow, _mm_set1_epi8(WEIGHTS[i])));
+        }
+        _mm_storeu_si128((__m128i*) (dst + half), pattern);
+    }
+}
+// sse2 END
+
+
+
+// avx2
+// same counting as generate_pattern, one answer per byte lane
+__attribute__((target("avx2")))
+static void generate_patterns_avx2(Word guess, const char *columns, size_t stride, Pattern *dst) {
+    __m256i actual[WORD_LEN];
+    __m256i not_green[WORD_LEN];
+    __m256i pattern = _mm256_setzero_si256();
+    for (int i = 0; i < WORD_LEN; i++) {
+        actual[i] = _mm256_loadu_si256((const __m256i*) (columns + i * stride));
+        __m256i green = _mm256_cmpeq_epi8(actual[i], _mm256_set1_epi8(guess.val[i]));
+        not_green[i] = _mm256_andnot_si256(green, _mm256_set1_epi8(-1));
+        pattern = _mm256_add_epi8(pattern, _mm256_and_si256(green, _mm256_set1_epi8((char) (2 * WEIGHTS[i]))));
+    }
+    for (int i = 0; i < WORD_LEN; i++) {
+        __m256i letter = _mm256_set1_epi8(guess.val[i]);
+        // lane masks are -1, so both sums below are negated counts
+        __m256i left = _mm256_setzero_si256();
+        for (int k = 0; k < WORD_LEN; k++) {
+            left = _mm256_add_epi8(left, _mm256_and_si256(_mm256_cmpeq_epi8(actual[k], letter), not_green[k]));
+        }
+        __m256i taken = _mm256_setzero_si256();
+        for (int j = 0; j < i; j++) {
+            if (guess.val[j] == guess.val[i]) {
+                taken = _mm256_add_epi8(taken, not_green[j]);
+            }
+        }
+        __m256i yellow = _mm256_and_si256(_mm256_cmpgt_epi8(taken, left), not_green[i]);
+        pattern = _mm256_add_epi8(pattern, _mm256_and_si256(yellow, _mm256_set1_epi8(WEIGHTS[i])));
+    }
+    _mm256_storeu_si256((__m256i*) dst, pattern);
+}
+
+// lane order for moving the kept lanes of an 8 lane mask to the front
+static uint32_t COMPACT_PERMUTATIONS[256][8];
+
+static void init_compact_permutations(void) {
+    for (int mask = 0; mask < 256; mask++) {
+        int kept = 0;
+        for (int lane = 0; lane < 8; lane++) {
+            if (mask & (1 << lane)) {
+                COMPACT_PERMUTATIONS[mask][kept++] = lane;
+            }
+        }
+        while (kept < 8) {
+            COMPACT_PERMUTATIONS[mask][kept++] = 0;
+        }
+    }
+}
+
+// a 4 byte gather ending at the cell keeps the cell in the top byte of the lane and never reads past the matrix
+__attribute__((target("avx2,popcnt")))
+static size_t filter_patterns_avx2(const Pattern *row, Pattern pattern, const WordIndex *src, size_t count, WordIndex *dst) {
+    const __m256i expected = _mm256_set1_epi32(pattern);
+    size_t kept = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i words = _mm256_loadu_si256((const __m256i*) (src + i));
+        __m256i cells = _mm256_srli_epi32(_mm256_i32gather_epi32((const int*) (row - 3), words, 1), 24);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(cells, expected)));
+        __m256i permutation = _mm256_loadu_si256((const __m256i*) COMPACT_PERMUTATIONS[mask]);
+        // writes at most up to dst + i + 8, which was already loaded when dst is src
+        _mm256_storeu_si256((__m256i*) (dst + kept), _mm256_permutevar8x32_epi32(words, permutation));
+        kept += __builtin_popcount(mask);
+    }
+    return kept + filter_patterns_scalar(row, pattern, src + i, count - i, dst + kept);
+}
+// avx2 END
+
+
+
+// avx512
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+static void generate_patterns_avx512(Word guess, const char *columns, size_t stride, Pattern *dst) {
+    __m256i actual[WORD_LEN];
+    __mmask32 not_green[WORD_LEN];
+    __m256i pattern = _mm256_setzero_si256();
+    for (int i = 0; i < WORD_LEN; i++) {
+        actual[i] = _mm256_loadu_si256((const __m256i*) (columns + i * stride));
+        __mmask32 green = _mm256_cmpeq_epi8_mask(actual[i], _mm256_set1_epi8(guess.val[i]));
+        not_green[i] = ~green;
+        pattern = _mm256_mask_add_epi8(pattern, green, pattern, _mm256_set1_epi8((char) (2 * WEIGHTS[i])));
+    }
+    const __m256i one = _mm256_set1_epi8(1);
+    for (int i = 0; i < WORD_LEN; i++) {
+        __m256i letter = _mm256_set1_epi8(guess.val[i]);
+        __m256i left = _mm256_setzero_si256();
+        for (int k = 0; k < WORD_LEN; k++) {
+            __mmask32 same = _mm256_mask_cmpeq_epi8_mask(not_green[k], actual[k], letter);
+            left = _mm256_mask_add_epi8(left, same, left, one);
+        }
+        __m256i taken = _mm256_setzero_si256();
+        for (int j = 0; j < i; j++) {
+            if (guess.val[j] == guess.val[i]) {
+                taken = _mm256_mask_add_epi8(taken, not_green[j], taken, one);
+            }
+        }
+        __mmask32 yellow = _mm256_mask_cmpgt_epi8_mask(not_green[i], left, taken);
+        pattern = _mm256_mask_add_epi8(pattern, yellow, pattern, _mm256_set1_epi8(WEIGHTS[i]));
+    }
+    _mm256_storeu_si256((__m256i*) dst, pattern);
+}
+
+__attribute__((target("avx512f,popcnt")))
+static size_t filter_patterns_avx512(const Pattern *row, Pattern pattern, const WordIndex *src, size_t count, WordIndex *dst) {
+    const __m512i expected = _mm512_set1_epi32(pattern);
+    size_t kept = 0;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i words = _mm512_loadu_si512(src + i);
+        __m512i cells = _mm512_srli_epi32(_mm512_i32gather_epi32(words, row - 3, 1), 24);
+        __mmask16 mask = _mm512_cmpeq_epi32_mask(cells, expected);
+        _mm512_mask_compressstoreu_epi32(dst + kept, mask, words);
+        kept += __builtin_popcount(mask);
+    }
+    return kept + filter_patterns_scalar(row, pattern, src + i, count - i, dst + kept);
+}
+// avx512 END
+#endif
+
+
+
+// dispatch
+// histograms are bound to the scalar kernel on every level: the increments serialize anyway,
+// and gathering the cells first measured no faster than plain loads
+static const Kernels ALL_KERNELS[] = {
+    [KERNELS_SCALAR] = {
+        .level = KERNELS_SCALAR, .name = "scalar",
+        .feedback = generate_patterns_scalar,
+        .filter = filter_patterns_scalar,
+        .histogram = count_patterns_scalar,
+    },
+#ifdef __x86_64__
+    [KERNELS_SSE2] = {
+        .level = KERNELS_SSE2, .name = "sse2",
+        .feedback = generate_patterns_sse2,
+        .filter = filter_patterns_scalar,
+        .histogram = count_patterns_scalar,
+    },
+    [KERNELS_AVX2] = {
+        .level = KERNELS_AVX2, .name = "avx2",
+        .feedback = generate_patterns_avx2,
+        .filter = filter_patterns_avx2,
+        .histogram = count_patterns_scalar,
+    },
+    [KERNELS_AVX512] = {
+        .level = KERNELS_AVX512, .name = "avx512",
+        .feedback = generate_patterns_avx512,
+        .filter = filter_patterns_avx512,
+        .histogram = count_patterns_scalar,
+    },
+#endif
+};
+
+static const Kernels *SELECTED_KERNELS = NULL;
+static pthread_once_t KERNELS_ONCE = PTHREAD_ONCE_INIT;
+static pthread_once_t PERMUTATIONS_ONCE = PTHREAD_ONCE_INIT;
+
+static KernelsLevel detect_level(void) {
+#ifdef __x86_64__
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl")) {
+        return KERNELS_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return KERNELS_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return KERNELS_SSE2;
+    }
+#endif
+    return KERNELS_SCALAR;
+}
+
+static void select_kernels(void) {
+    KernelsLevel level = detect_level();
+
+    const char *forced = getenv(KERNELS_ENV);
+    if (forced != NULL) {
+        size_t count = sizeof(ALL_KERNELS) / sizeof(ALL_KERNELS[0]);
+        size_t i = 0;
+        while (i < count && strcmp(forced, ALL_KERNELS[i].name) != 0) i++;
+        if (i == count) {
+            fprintf(stderr, "%s: unknown kernels %s, using %s\n", KERNELS_ENV, forced, ALL_KERNELS[level].name);
+        } else if ((KernelsLevel) i > level) {
+            fprintf(stderr, "%s: cpu does not support %s, using %s\n", KERNELS_ENV, forced, ALL_KERNELS[level].name);
+        } else {
+            level = i;
+        }
+    }
+
+#ifdef __x86_64__
+    if (level >= KERNELS_AVX2) {
+        pthread_once(&PERMUTATIONS_ONCE, init_compact_permutations);
+    }
+#endif
+    SELECTED_KERNELS = &ALL_KERNELS[level];
+}
+
+const Kernels* get_kernels(void) {
+    pthread_once(&KERNELS_ONCE, select_kernels);
+    return SELECTED_KERNELS;
+}
+
+const Kernels* get_kernels_at(KernelsLevel level) {
+    if (level >= sizeof(ALL_KERNELS) / sizeof(ALL_KERNELS[0]) || level > detect_level()) return NULL;
+#ifdef __x86_64__
+    if (level >= KERNELS_AVX2) {
+        pthread_once(&PERMUTATIONS_ONCE, init_compact_permutations);
+    }
+#endif
+    return &ALL_KERNELS[level];
+}
+// dispatch END
@@ -0,0 +1,45 @@
+#ifndef KERNELS_H_
+#define KERNELS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "solver.h"
+#include "pattern.h"
+
+// feedback: one guess against PATTERN_BATCH answers stored column-wise,
+// columns[i * stride + j] is the i-th letter of the j-th answer
+#define PATTERN_BATCH 32
+typedef void (*PatternBatchKernel)(Word guess, const char *columns, size_t stride, Pattern *dst);
+
+// filter: keeps words of src whose pattern in the guess row equals pattern, dst may be src
+typedef size_t (*FilterKernel)(const Pattern *row, Pattern pattern, const WordIndex *src, size_t count, WordIndex *dst);
+
+// histogram: adds the number of words of src giving each pattern in the guess row to counts
+typedef void (*HistogramKernel)(const Pattern *row, const WordIndex *src, size_t count, uint32_t counts[PATTERN_COUNT]);
+
+typedef enum {
+    KERNELS_SCALAR,
+    KERNELS_SSE2,
+    KERNELS_AVX2,
+    KERNELS_AVX512,
+} KernelsLevel;
+
+typedef struct {
+    KernelsLevel level;
+    const char *name;
+    PatternBatchKernel feedback;
+    FilterKernel filter;
+    HistogramKernel histogram;
+} Kernels;
+
+// forces a level for testing: scalar, sse2, avx2 or avx512; levels above what the CPU has are ignored
+#define KERNELS_ENV "SOLVER_KERNELS"
+
+// best kernels for this CPU, detected on the first call
+const Kernels* get_kernels(void);
+
+// the kernels of the given level, SOLVER_KERNELS is ignored; NULL when the CPU does not support it
+const Kernels* get_kernels_at(KernelsLevel level);
+
+#endif //KERNELS_H_
@@ -2,12 +2,80 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <math.h>
 #include <stdbool.h>
+#include <unistd.h>
 
 #include "solver.h"
 
 
-int main(void) {
+static void parse_args(int argc, char **argv) {
+    size_t workers_count = 0;
+    bool pin = false;
+    int option;
+    while ((option = getopt(argc, argv, "j:pl:e:t:")) != -1) {
+        switch (option) {
+            case 'j': {
+                char *end;
+                long count = strtol(optarg, &end, 10);
+                if (*end != '\0' || count < 1) {
+                    fprintf(stderr, "-j expects a positive number of workers\n");
+                    exit(-1);
+                }
+                workers_count = count;
+                break;
+            }
+            case 'p':
+                pin = true;
+                break;
+            case 'l': {
+                char *end;
+                long top_count = strtol(optarg, &end, 10);
+                double budget_seconds = 0;
+                bool is_parsed = end != optarg && top_count >= 0;
+                if (!is_parsed) {
+                    end = optarg;
+                } else if (*end == ',') {
+                    char *seconds = end + 1;
+                    budget_seconds = strtod(seconds, &end);
+                    is_parsed = end != seconds;
+                    if (!is_parsed) end = seconds - 1; // the unparsed text starts at the comma
+                }
+                if (!is_parsed || *end != '\0') {
+                    fprintf(stderr, "-l expects the guesses to look into, optionally followed by ,seconds; "
+                                    "cannot parse \"%s\"\n", end);
+                    exit(-1);
+                }
+                if (!isfinite(budget_seconds) || budget_seconds < 0) {
+                    fprintf(stderr, "-l expects seconds finite and at least 0, not %s\n", optarg);
+                    exit(-1);
+                }
+                set_lookahead(top_count, budget_seconds);
+                break;
+            }
+            case 'e': {
+                char *end;
+                long count = strtol(optarg, &end, 10);
+                if (*end != '\0' || count < 0) {
+                    fprintf(stderr, "-e expects the candidates left to search the end game at\n");
+                    exit(-1);
+                }
+                set_endgame(count);
+                break;
+            }
+            case 't':
+                set_decision_tree(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-j workers] [-p] [-l guesses[,seconds]] [-e candidates] [-t tree_file]\n", argv[0]);
+                exit(-1);
+        }
+    }
+    set_workers(workers_count, pin);
+}
+
+int main(int argc, char **argv) {
+    parse_args(argc, argv);
     int probe_num = 1;
     while (get_probes_count() < MAX_PROBES) {
         Word guess = guess_word();
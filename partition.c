@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "partition.h"
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+uint64_t Partition_signature(const PatternMatrix *matrix, size_t guess_index,
+                             const WordIndex *candidates, size_t candidates_count) {
+    const Pattern *row = PatternMatrix_row(matrix, guess_index);
+    // 0 for the results not seen yet, groups count from 1; only the results seen are cleared after
+    static _Thread_local uint8_t group_of[PATTERN_COUNT];
+    Pattern seen[PATTERN_COUNT];
+    uint8_t groups_count = 0;
+    uint64_t signature = FNV_OFFSET;
+    for (size_t i = 0; i < candidates_count; i++) {
+        Pattern pattern = row[candidates[i]];
+        if (group_of[pattern] == 0) {
+            seen[groups_count] = pattern;
+            group_of[pattern] = ++groups_count;
+        }
+        signature = (signature ^ group_of[pattern]) * FNV_PRIME;
+    }
+    for (uint8_t group = 0; group < groups_count; group++) {
+        group_of[seen[group]] = 0;
+    }
+    return signature;
+}
+
+bool Partition_equals(const PatternMatrix *matrix, size_t guess_a, size_t guess_b,
+                      const WordIndex *candidates, size_t candidates_count) {
+    const Pattern *row_a = PatternMatrix_row(matrix, guess_a);
+    const Pattern *row_b = PatternMatrix_row(matrix, guess_b);
+    // the results of a are mapped to those of b plus 1, 0 for the results not mapped yet;
+    // results of b taken by another result of a are caught by mapping b back the same way
+    static _Thread_local uint8_t a_to_b[PATTERN_COUNT], b_to_a[PATTERN_COUNT];
+    bool equal = true;
+    size_t mapped = 0;
+    for (; mapped < candidates_count; mapped++) {
+        Pattern a = row_a[candidates[mapped]], b = row_b[candidates[mapped]];
+        if (a_to_b[a] == 0 && b_to_a[b] == 0) {
+            a_to_b[a] = b + 1;
+            b_to_a[b] = a + 1;
+        } else if (a_to_b[a] != b + 1 || b_to_a[b] != a + 1) {
+            equal = false;
+            break;
+        }
+    }
+    for (size_t i = 0; i < mapped; i++) {
+        a_to_b[row_a[candidates[i]]] = 0;
+        b_to_a[row_b[candidates[i]]] = 0;
+    }
+    return equal;
+}
+
+bool Partition_separates_all(const PatternMatrix *matrix, size_t guess_index,
+                             const WordIndex *candidates, size_t candidates_count) {
+    if (candidates_count > PATTERN_COUNT) return false;
+    const Pattern *row = PatternMatrix_row(matrix, guess_index);
+    uint64_t seen[(PATTERN_COUNT + 63) / 64] = {0};
+    for (size_t i = 0; i < candidates_count; i++) {
+        Pattern pattern = row[candidates[i]];
+        uint64_t bit = 1ULL << (pattern % 64);
+        if (seen[pattern / 64] & bit) return false;
+        seen[pattern / 64] |= bit;
+    }
+    return true;
+}
+
+void Partition_sort(const PatternMatrix *matrix, size_t guess_index, const WordIndex *candidates, size_t candidates_count,
+                    WordIndex *sorted, size_t offsets[PATTERN_COUNT + 1]) {
+    const Pattern *row = PatternMatrix_row(matrix, guess_index);
+    size_t next[PATTERN_COUNT] = {0};
+    for (size_t i = 0; i < candidates_count; i++) {
+        next[row[candidates[i]]]++;
+    }
+    offsets[0] = 0;
+    for (size_t r = 0; r < PATTERN_COUNT; r++) {
+        offsets[r + 1] = offsets[r] + next[r];
+        next[r] = offsets[r];
+    }
+    for (size_t i = 0; i < candidates_count; i++) {
+        sorted[next[row[candidates[i]]]++] = candidates[i];
+    }
+}
+
+size_t Partition_deduplicate(const PatternMatrix *matrix, const WordIndex *guesses, size_t guesses_count,
+                             const WordIndex *candidates, size_t candidates_count,
+                             const uint64_t *signatures, const bool *is_candidate, WordIndex *representatives) {
+    // open addressing over the representatives found so far, at most half full
+    size_t slots_count = 1;
+    while (slots_count < 2 * matrix->words_count) {
+        slots_count *= 2;
+    }
+    WordIndex *slots = malloc(slots_count * sizeof(WordIndex));
+    bool *is_representative = calloc(matrix->words_count, sizeof(bool));
+    if (slots == NULL || is_representative == NULL) {
+        fprintf(stderr, "cannot allocate partitions table\n");
+        exit(-1);
+    }
+    memset(slots, 0xff, slots_count * sizeof(WordIndex)); // NO_WORD_INDEX
+
+    for (size_t i = 0; i < guesses_count; i++) {
+        WordIndex guess = guesses[i];
+        size_t slot = signatures[guess] & (slots_count - 1);
+        for (; slots[slot] != NO_WORD_INDEX; slot = (slot + 1) & (slots_count - 1)) {
+            WordIndex other = slots[slot];
+            if (signatures[other] == signatures[guess]
+                && Partition_equals(matrix, other, guess, candidates, candidates_count)) {
+                break;
+            }
+        }
+        WordIndex other = slots[slot];
+        if (other == NO_WORD_INDEX) {
+            slots[slot] = guess;
+            is_representative[guess] = true;
+        } else if (is_candidate[guess] && !is_candidate[other]) {
+            slots[slot] = guess;
+            is_representative[other] = false;
+            is_representative[guess] = true;
+        }
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < guesses_count; i++) {
+        representatives[count] = guesses[i];
+        count += is_representative[guesses[i]];
+    }
+    free(is_representative);
+    free(slots);
+    return count;
+}
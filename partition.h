@@ -0,0 +1,35 @@
+#ifndef PARTITION_H_
+#define PARTITION_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pattern.h"
+
+// guesses grouping the candidates the same way, whatever the results, are worth the same now and later;
+// the signature hashes the groups numbered in order of their first candidate, so equal partitions sign equal
+uint64_t Partition_signature(const PatternMatrix *matrix, size_t guess_index,
+                             const WordIndex *candidates, size_t candidates_count);
+
+// exact check behind equal signatures: the results of both guesses map one to one
+bool Partition_equals(const PatternMatrix *matrix, size_t guess_a, size_t guess_b,
+                      const WordIndex *candidates, size_t candidates_count);
+
+// whether every candidate gives the guess a result of its own, so the guess leaves at most one of them
+bool Partition_separates_all(const PatternMatrix *matrix, size_t guess_index,
+                             const WordIndex *candidates, size_t candidates_count);
+
+// sorts the candidates by the result they give the guess, in their order within a result:
+// those giving result r go to sorted[offsets[r] .. offsets[r + 1])
+void Partition_sort(const PatternMatrix *matrix, size_t guess_index, const WordIndex *candidates, size_t candidates_count,
+                    WordIndex *sorted, size_t offsets[PATTERN_COUNT + 1]);
+
+// keeps one of the guesses per partition, in their order: the first possible answer of it, else its first guess;
+// signatures and is_candidate are indexed by word, representatives may be guesses itself;
+// returns how many guesses were written to representatives
+size_t Partition_deduplicate(const PatternMatrix *matrix, const WordIndex *guesses, size_t guesses_count,
+                             const WordIndex *candidates, size_t candidates_count,
+                             const uint64_t *signatures, const bool *is_candidate, WordIndex *representatives);
+
+#endif //PARTITION_H_
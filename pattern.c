@@ -0,0 +1,243 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pattern.h"
+#include "kernels.h"
+#include "pool.h"
+
+Pattern generate_pattern(Word guess, Word actual) {
+    // no data dependent branches: letters of actual that are not green are counted once,
+    // then every non green letter of guess takes one of them from left to right to become yellow
+    uint8_t green[WORD_LEN];
+    uint8_t left[32] = {0}; // indexed by the low 5 bits of a letter
+    for (int i = 0; i < WORD_LEN; i++) {
+        green[i] = guess.val[i] == actual.val[i];
+        left[actual.val[i] & 31] += !green[i];
+    }
+
+    Pattern pattern = 0;
+    for (int i = 0; i < WORD_LEN; i++) {
+        uint8_t *letter_left = &left[guess.val[i] & 31];
+        uint8_t yellow = !green[i] & (*letter_left > 0);
+        *letter_left -= yellow;
+        pattern = pattern * 3 + green[i] * 2 + yellow;
+    }
+    return pattern;
+}
+
+Word generate_result(Word guess, Word actual) {
+    return Pattern_to_result(generate_pattern(guess, actual));
+}
+
+Pattern Pattern_from_result(Word result) {
+    int index = 0;
+    for (int i = 0; i < WORD_LEN; i++) {
+        int value;
+        switch (result.val[i]) {
+            case GRAY:   value = 0; break;
+            case YELLOW: value = 1; break;
+            case GREEN:  value = 2; break;
+            default:
+                fprintf(stderr, "unknown color %d", result.val[i]);
+                exit(-1);
+        }
+        index *= 3;
+        index += value;
+    }
+    return index;
+}
+
+Word Pattern_to_result(Pattern pattern) {
+    static const Color COLORS[] = { GRAY, YELLOW, GREEN };
+    Word result;
+    for (int i = WORD_LEN - 1; i >= 0; i--) {
+        result.val[i] = COLORS[pattern % 3];
+        pattern /= 3;
+    }
+    return result;
+}
+
+
+
+
+
+
+// matrix building
+typedef struct {
+    Pattern *cells;
+    size_t words_count;
+    const Word *words;
+    const char *columns;
+    size_t stride;
+    PatternBatchKernel kernel;
+    size_t guess_from;
+    size_t guess_to;
+} BuildInfo;
+
+static void* build_routine(void* arg) {
+    BuildInfo* info = arg;
+    size_t count = info->words_count;
+    for (size_t guess_i = info->guess_from; guess_i < info->guess_to; guess_i++) {
+        Pattern *row = info->cells + guess_i * count;
+        for (size_t actual_i = 0; actual_i < count; actual_i += PATTERN_BATCH) {
+            Pattern batch[PATTERN_BATCH];
+            info->kernel(info->words[guess_i], info->columns + actual_i, info->stride, batch);
+            size_t batch_size = count - actual_i < PATTERN_BATCH ? count - actual_i : PATTERN_BATCH;
+            memcpy(row + actual_i, batch, batch_size);
+        }
+    }
+    return NULL;
+}
+
+void PatternMatrix_init(PatternMatrix *matrix, const Word *words, size_t words_count) {
+    // same layout as the mapped file, so cells are always preceded by a header
+    uint8_t *buffer = malloc(sizeof(PatternsFileHeader) + words_count * words_count * sizeof(Pattern));
+    if (buffer == NULL) {
+        fprintf(stderr, "cannot allocate pattern matrix\n");
+        exit(-1);
+    }
+    Pattern *cells = (Pattern*) (buffer + sizeof(PatternsFileHeader));
+
+    // answers column-wise, padded to whole batches
+    size_t stride = (words_count + PATTERN_BATCH - 1) / PATTERN_BATCH * PATTERN_BATCH;
+    char *columns = calloc(WORD_LEN * stride, sizeof(char));
+    if (columns == NULL) {
+        fprintf(stderr, "cannot allocate pattern matrix columns\n");
+        exit(-1);
+    }
+    for (size_t j = 0; j < words_count; j++) {
+        for (int i = 0; i < WORD_LEN; i++) {
+            columns[i * stride + j] = words[j].val[i];
+        }
+    }
+    PatternBatchKernel kernel = get_kernels()->feedback;
+
+    long threads_count = available_cpus_count();
+    pthread_t threads[threads_count];
+    BuildInfo infos[threads_count];
+    for (long i = 0; i < threads_count; i++) {
+        infos[i] = (BuildInfo) {
+            .cells = cells,
+            .words_count = words_count,
+            .words = words,
+            .columns = columns,
+            .stride = stride,
+            .kernel = kernel,
+            .guess_from = words_count * i / threads_count,
+            .guess_to = words_count * (i + 1) / threads_count,
+        };
+        if (pthread_create(threads + i, NULL, build_routine, infos + i) != 0) {
+            fprintf(stderr, "cannot create matrix builder thread\n");
+            exit(-1);
+        }
+    }
+    for (long i = 0; i < threads_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(columns);
+    matrix->cells = cells;
+    matrix->words_count = words_count;
+}
+// matrix building END
+
+
+
+// matrix file
+uint64_t words_checksum(const Word *words, size_t words_count) {
+    // FNV-1a over all letters
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < words_count; i++) {
+        for (int j = 0; j < WORD_LEN; j++) {
+            hash ^= (uint8_t) words[i].val[j];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+bool PatternMatrix_load(PatternMatrix *matrix, const char *path, const Word *words, size_t words_count) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    size_t expected_size = sizeof(PatternsFileHeader) + words_count * words_count * sizeof(Pattern);
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size != expected_size) {
+        fprintf(stderr, "%s: unexpected size, ignoring it\n", path);
+        close(fd);
+        return false;
+    }
+    void *mapping = mmap(NULL, expected_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "%s: cannot mmap, ignoring it\n", path);
+        return false;
+    }
+
+    const PatternsFileHeader *header = mapping;
+    if (memcmp(header->magic, PATTERNS_FILE_MAGIC, sizeof(header->magic)) != 0
+            || header->encoding_version != PATTERN_ENCODING_VERSION
+            || header->words_count != words_count
+            || header->words_checksum != words_checksum(words, words_count)) {
+        fprintf(stderr, "%s: stale or foreign pattern file, ignoring it\n", path);
+        munmap(mapping, expected_size);
+        return false;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (getenv(PATTERNS_HUGEPAGES_ENV) != NULL) {
+        madvise(mapping, expected_size, MADV_HUGEPAGE);
+    }
+#endif
+
+    matrix->cells = (const Pattern*) (header + 1);
+    matrix->words_count = words_count;
+    return true;
+}
+
+void PatternMatrix_save(const PatternMatrix *matrix, const char *path, const Word *words) {
+    PatternsFileHeader header = {
+        .encoding_version = PATTERN_ENCODING_VERSION,
+        .words_count = matrix->words_count,
+        .words_checksum = words_checksum(words, matrix->words_count),
+    };
+    memcpy(header.magic, PATTERNS_FILE_MAGIC, sizeof(header.magic));
+
+    // written aside and renamed, so processes that have the old file mapped are not disturbed
+    char tmp_path[strlen(path) + sizeof(".tmp")];
+    sprintf(tmp_path, "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "cannot open %s\n", tmp_path);
+        exit(-1);
+    }
+    size_t cells_count = matrix->words_count * matrix->words_count;
+    if (fwrite(&header, sizeof(header), 1, file) != 1
+            || fwrite(matrix->cells, sizeof(Pattern), cells_count, file) != cells_count
+            || fclose(file) != 0) {
+        fprintf(stderr, "cannot write %s\n", tmp_path);
+        exit(-1);
+    }
+    if (rename(tmp_path, path) != 0) {
+        fprintf(stderr, "cannot rename %s to %s\n", tmp_path, path);
+        exit(-1);
+    }
+}
+
+void PatternMatrix_open(PatternMatrix *matrix, const Word *words, size_t words_count) {
+    const char *path = getenv(PATTERNS_FILE_ENV);
+    if (path == NULL) {
+        path = PATTERNS_FILE_DEFAULT;
+    }
+    if (!PatternMatrix_load(matrix, path, words, words_count)) {
+        PatternMatrix_init(matrix, words, words_count);
+    }
+}
+// matrix file END
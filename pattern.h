@@ -0,0 +1,100 @@
+#ifndef PATTERN_H_
+#define PATTERN_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "solver.h"
+
+#define PATTERN_COUNT 243 // 243 = 3 ** 5; 3 stands for 3 possible result colors
+#define PATTERN_ALL_GREEN (PATTERN_COUNT - 1)
+
+// base-3 code of a result, first letter is the most significant digit: GRAY = 0, YELLOW = 1, GREEN = 2
+typedef uint8_t Pattern;
+#define PATTERN_GRAY 0
+#define PATTERN_YELLOW 1
+#define PATTERN_GREEN 2
+// bump it whenever the meaning of a Pattern value changes, stale pattern files are rejected then
+#define PATTERN_ENCODING_VERSION 1
+
+typedef uint32_t WordIndex;
+#define NO_WORD_INDEX (~(WordIndex)(0))
+
+// lowercase word in one register: five 5 bit letters, the first letter in the lowest bits
+typedef uint32_t PackedWord;
+#define PACKED_LETTER_BITS 5
+
+static inline PackedWord Word_pack(Word word) {
+    PackedWord packed = 0;
+    for (int i = 0; i < WORD_LEN; i++) {
+        packed |= (PackedWord) (word.val[i] & 31) << (i * PACKED_LETTER_BITS);
+    }
+    return packed;
+}
+
+static inline int PackedWord_letter(PackedWord packed, int i) {
+    return (packed >> (i * PACKED_LETTER_BITS)) & 31;
+}
+
+// letters of the word as a bit mask indexed by the 5 bit packed letter
+static inline uint32_t PackedWord_letters(PackedWord packed) {
+    uint32_t letters = 0;
+    for (int i = 0; i < WORD_LEN; i++) {
+        letters |= 1u << PackedWord_letter(packed, i);
+    }
+    return letters;
+}
+
+static inline Word PackedWord_unpack(PackedWord packed) {
+    Word word;
+    for (int i = 0; i < WORD_LEN; i++) {
+        word.val[i] = 0x60 | PackedWord_letter(packed, i);
+    }
+    return word;
+}
+
+// feedback of every dictionary word as a guess against every dictionary word as an answer,
+// cells are always preceded by a PatternsFileHeader (vector gathers may read a few bytes before a cell)
+typedef struct {
+    const Pattern *cells;
+    size_t words_count;
+} PatternMatrix;
+
+// on-disk matrix: the header is followed by words_count * words_count cells in row-major order
+#define PATTERNS_FILE_MAGIC "WRDLPTRN"
+#define PATTERNS_FILE_DEFAULT "patterns.bin"
+#define PATTERNS_FILE_ENV "PATTERNS_FILE"
+#define PATTERNS_HUGEPAGES_ENV "PATTERNS_HUGEPAGES"
+
+typedef struct {
+    char magic[8];
+    uint32_t encoding_version;
+    uint32_t words_count;
+    uint64_t words_checksum;
+    uint8_t reserved[40]; // keeps the cells cache line aligned
+} PatternsFileHeader;
+
+Pattern generate_pattern(Word guess, Word actual);
+
+// conversions for the I/O layer, where results are strings of GRAY / YELLOW / GREEN
+Pattern Pattern_from_result(Word result);
+Word Pattern_to_result(Pattern pattern);
+
+uint64_t words_checksum(const Word *words, size_t words_count);
+
+void PatternMatrix_init(PatternMatrix *matrix, const Word *words, size_t words_count);
+bool PatternMatrix_load(PatternMatrix *matrix, const char *path, const Word *words, size_t words_count);
+void PatternMatrix_save(const PatternMatrix *matrix, const char *path, const Word *words);
+// maps the file from PATTERNS_FILE_ENV (or PATTERNS_FILE_DEFAULT), builds the matrix in memory if it is missing or stale
+void PatternMatrix_open(PatternMatrix *matrix, const Word *words, size_t words_count);
+
+static inline const Pattern* PatternMatrix_row(const PatternMatrix *matrix, size_t guess_index) {
+    return matrix->cells + guess_index * matrix->words_count;
+}
+
+static inline Pattern PatternMatrix_get(const PatternMatrix *matrix, size_t guess_index, size_t actual_index) {
+    return PatternMatrix_row(matrix, guess_index)[actual_index];
+}
+
+#endif //PATTERN_H_
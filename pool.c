@@ -0,0 +1,285 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <sched.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "pool.h"
+
+// a job that ends quickly is often followed by the next one, so waiters spin a little before sleeping
+#define POOL_SPINS 256
+
+typedef struct {
+    WorkerPool *pool;
+    size_t index;
+} PoolWorker;
+
+
+
+// waiting
+#ifdef __linux__
+static void wait_while_equal(WorkerPool *pool, _Atomic uint32_t *word, uint32_t value) {
+    (void) pool;
+    while (atomic_load_explicit(word, memory_order_acquire) == value) {
+        // returns at once if the word already changed, so a wake up cannot be lost
+        syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+    }
+}
+
+static void wake_all(WorkerPool *pool, _Atomic uint32_t *word) {
+    (void) pool;
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+}
+#else
+static void wait_while_equal(WorkerPool *pool, _Atomic uint32_t *word, uint32_t value) {
+    if (pthread_mutex_lock(&pool->mutex) != 0) {
+        fprintf(stderr, "cannot lock mutex\n");
+        exit(-1);
+    }
+    while (atomic_load_explicit(word, memory_order_acquire) == value) {
+        if (pthread_cond_wait(&pool->changed, &pool->mutex) != 0) {
+            fprintf(stderr, "failed waiting for condition\n");
+            exit(-1);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void wake_all(WorkerPool *pool, _Atomic uint32_t *word) {
+    (void) word;
+    // taking the mutex orders the store before any waiter's check
+    pthread_mutex_lock(&pool->mutex);
+    if (pthread_cond_broadcast(&pool->changed) != 0) {
+        fprintf(stderr, "failed signal condition\n");
+        exit(-1);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+#endif
+
+static void await_change(WorkerPool *pool, _Atomic uint32_t *word, uint32_t value) {
+    for (int i = 0; i < POOL_SPINS; i++) {
+        if (atomic_load_explicit(word, memory_order_acquire) != value) return;
+    }
+    wait_while_equal(pool, word, value);
+}
+// waiting END
+
+
+
+// sizing
+#ifdef __linux__
+// whole CPUs allowed by a quota / period pair, 0 when there is no quota
+static size_t quota_cpus(long long quota, long long period) {
+    if (quota <= 0 || period <= 0) return 0;
+    return (quota + period - 1) / period;
+}
+
+static size_t cgroup_cpus_count(void) {
+    long long quota, period;
+    FILE *file = fopen("/sys/fs/cgroup/cpu.max", "r"); // cgroup v2: "max 100000" or "200000 100000"
+    if (file != NULL) {
+        size_t count = fscanf(file, "%lld %lld", &quota, &period) == 2 ? quota_cpus(quota, period) : 0;
+        fclose(file);
+        return count;
+    }
+    file = fopen("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "r"); // cgroup v1, -1 without a quota
+    if (file == NULL) return 0;
+    bool has_quota = fscanf(file, "%lld", &quota) == 1;
+    fclose(file);
+    file = fopen("/sys/fs/cgroup/cpu/cpu.cfs_period_us", "r");
+    if (file == NULL) return 0;
+    bool has_period = fscanf(file, "%lld", &period) == 1;
+    fclose(file);
+    return has_quota && has_period ? quota_cpus(quota, period) : 0;
+}
+#endif
+
+size_t available_cpus_count(void) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t count = online > 0 ? online : 1;
+#ifdef __linux__
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0) {
+        count = CPU_COUNT(&set);
+    }
+    size_t quota = cgroup_cpus_count();
+    if (quota > 0 && quota < count) {
+        count = quota;
+    }
+#endif
+    return count;
+}
+
+double seconds_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static size_t env_workers_count(void) {
+    const char *value = getenv(WORKERS_ENV);
+    if (value == NULL) return 0;
+    char *end;
+    long count = strtol(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || count < 1) {
+        fprintf(stderr, "%s=%s is not a number of workers, ignoring it\n", WORKERS_ENV, value);
+        return 0;
+    }
+    return count;
+}
+
+static void pin_thread(pthread_t thread, size_t worker_index) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0) return;
+    size_t nth = worker_index % CPU_COUNT(&allowed);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed) || nth-- > 0) continue;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(thread, sizeof(set), &set) != 0) {
+            fprintf(stderr, "cannot pin worker %zu to CPU %d\n", worker_index, cpu);
+        }
+        return;
+    }
+#else
+    (void) thread;
+    (void) worker_index;
+#endif
+}
+// sizing END
+
+
+
+// every worker arrives once per generation, the last one releases the dispatcher
+static void arrive(WorkerPool *pool) {
+    uint32_t sense = atomic_load_explicit(&pool->sense, memory_order_relaxed);
+    if (atomic_fetch_add_explicit(&pool->arrived, 1, memory_order_acq_rel) + 1 == pool->workers_count) {
+        atomic_store_explicit(&pool->arrived, 0, memory_order_relaxed);
+        atomic_store_explicit(&pool->sense, !sense, memory_order_release);
+        wake_all(pool, &pool->sense);
+    }
+}
+
+static void* worker_routine(void* arg) {
+    PoolWorker worker = *(PoolWorker*) arg;
+    free(arg);
+    WorkerPool *pool = worker.pool;
+    uint32_t seen = 0;
+    while (true) {
+        await_change(pool, &pool->generation, seen);
+        seen = atomic_load_explicit(&pool->generation, memory_order_acquire);
+        pool->job(pool->arg, worker.index);
+        arrive(pool);
+    }
+    return NULL;
+}
+
+void WorkerPool_init(WorkerPool *pool, size_t workers_count, bool pin) {
+    if (workers_count == 0) workers_count = env_workers_count();
+    if (workers_count == 0) workers_count = available_cpus_count();
+    pin = pin || getenv(PIN_WORKERS_ENV) != NULL;
+    pool->workers_count = workers_count;
+    pool->job = NULL;
+    pool->arg = NULL;
+    atomic_init(&pool->generation, 0);
+    atomic_init(&pool->arrived, 0);
+    atomic_init(&pool->sense, 0);
+    pool->dispatcher_sense = 0;
+#ifndef __linux__
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->changed, NULL);
+#endif
+
+    pool->threads = malloc(workers_count * sizeof(pthread_t));
+    if (pool->threads == NULL) {
+        fprintf(stderr, "cannot allocate workers\n");
+        exit(-1);
+    }
+    for (size_t i = 1; i < workers_count; i++) {
+        PoolWorker *worker = malloc(sizeof(PoolWorker));
+        if (worker == NULL) {
+            fprintf(stderr, "cannot allocate workers\n");
+            exit(-1);
+        }
+        *worker = (PoolWorker) { .pool = pool, .index = i };
+        if (pthread_create(pool->threads + i, NULL, worker_routine, worker) != 0) {
+            fprintf(stderr, "cannot create worker thread\n");
+            exit(-1);
+        }
+        if (pin) {
+            pin_thread(pool->threads[i], i);
+        }
+    }
+}
+
+void WorkerPool_run(WorkerPool *pool, PoolJob job, void *arg) {
+    if (pool->workers_count == 1) {
+        job(arg, 0);
+        return;
+    }
+    pool->job = job;
+    pool->arg = arg;
+    // the release publishes job and arg together with the new generation
+    atomic_fetch_add_explicit(&pool->generation, 1, memory_order_release);
+    wake_all(pool, &pool->generation);
+
+    job(arg, 0);
+    arrive(pool);
+    await_change(pool, &pool->sense, pool->dispatcher_sense);
+    pool->dispatcher_sense = !pool->dispatcher_sense;
+}
+
+
+
+// work queue
+void WorkQueue_init(WorkQueue *queue, size_t workers_count) {
+    if (workers_count < 1) workers_count = 1;
+    queue->slices_count = workers_count;
+    queue->slices = aligned_alloc(sizeof(WorkSlice), workers_count * sizeof(WorkSlice));
+    if (queue->slices == NULL) {
+        fprintf(stderr, "cannot allocate work queue\n");
+        exit(-1);
+    }
+    WorkQueue_reset(queue, 0, 1);
+}
+
+void WorkQueue_reset(WorkQueue *queue, size_t count, size_t chunk_size) {
+    queue->chunk_size = chunk_size < 1 ? 1 : chunk_size;
+    for (size_t i = 0; i < queue->slices_count; i++) {
+        atomic_store_explicit(&queue->slices[i].next, count * i / queue->slices_count, memory_order_relaxed);
+        queue->slices[i].end = count * (i + 1) / queue->slices_count;
+    }
+}
+
+static bool claim_from(WorkQueue *queue, size_t slice_index, size_t *from, size_t *to) {
+    WorkSlice *slice = queue->slices + slice_index;
+    if (atomic_load_explicit(&slice->next, memory_order_relaxed) >= slice->end) return false;
+    size_t start = atomic_fetch_add_explicit(&slice->next, queue->chunk_size, memory_order_relaxed);
+    if (start >= slice->end) return false;
+    *from = start;
+    *to = start + queue->chunk_size < slice->end ? start + queue->chunk_size : slice->end;
+    return true;
+}
+
+bool WorkQueue_claim(WorkQueue *queue, size_t worker_index, size_t *from, size_t *to, bool *stolen) {
+    *stolen = false;
+    if (claim_from(queue, worker_index, from, to)) return true;
+    *stolen = true;
+    for (size_t i = 1; i < queue->slices_count; i++) {
+        if (claim_from(queue, (worker_index + i) % queue->slices_count, from, to)) return true;
+    }
+    return false;
+}
+// work queue END
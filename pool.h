@@ -0,0 +1,75 @@
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// runs one job on every worker, worker_index is 0 .. workers_count - 1
+typedef void (*PoolJob)(void *arg, size_t worker_index);
+
+// the calling thread is worker 0, the others are parked threads woken by a generation counter
+// and joined with a sense-reversing barrier, both waited on with a futex (a condvar elsewhere)
+typedef struct {
+    size_t workers_count;
+    pthread_t *threads;
+
+    PoolJob job;
+    void *arg;
+
+    _Atomic uint32_t generation; // bumped by every dispatch
+    _Atomic uint32_t arrived;    // workers done with the current generation, the last one resets it
+    _Atomic uint32_t sense;      // flipped by the last worker to arrive
+    uint32_t dispatcher_sense;
+
+#ifndef __linux__
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+#endif
+} WorkerPool;
+
+// overrides the number of workers when the caller does not give one
+#define WORKERS_ENV "SOLVER_WORKERS"
+// any value pins the workers as if the caller asked for it
+#define PIN_WORKERS_ENV "SOLVER_PIN_WORKERS"
+
+// CPUs this process may use: its affinity mask, cut down to the cgroup CPU quota
+size_t available_cpus_count(void);
+
+// seconds on the monotonic clock, for timings and deadlines
+double seconds_now(void);
+
+// workers_count 0 takes WORKERS_ENV or else the available CPUs;
+// pinned workers stay on the i-th CPU of the affinity mask, the dispatching thread is left alone
+void WorkerPool_init(WorkerPool *pool, size_t workers_count, bool pin);
+
+// runs job(arg, i) for every worker i and returns once all of them are done;
+// cheap enough to call many times per guess, but only one thread may dispatch at a time
+void WorkerPool_run(WorkerPool *pool, PoolJob job, void *arg);
+
+// work of count items split into per-worker slices claimed a chunk at a time;
+// a worker whose slice is done steals chunks from the others, so a slow one does not hold up the rest
+typedef struct {
+    _Atomic size_t next;
+    size_t end;
+    char padding[64 - sizeof(size_t) * 2]; // a slice per cache line
+} WorkSlice;
+
+typedef struct {
+    size_t slices_count;
+    WorkSlice *slices;
+    size_t chunk_size;
+} WorkQueue;
+
+void WorkQueue_init(WorkQueue *queue, size_t workers_count);
+
+// not thread safe, call it before dispatching
+void WorkQueue_reset(WorkQueue *queue, size_t count, size_t chunk_size);
+
+// claims the next chunk [*from, *to) for the worker, false once everything has been claimed;
+// *stolen tells whether the chunk came from another worker's slice
+bool WorkQueue_claim(WorkQueue *queue, size_t worker_index, size_t *from, size_t *to, bool *stolen);
+
+#endif //POOL_H_
@@ -0,0 +1,50 @@
+#include "ranking.h"
+
+void TopGuesses_clear(TopGuesses *top, RankingOrder order) {
+    top->order = order;
+    top->count = 0;
+}
+
+void TopGuesses_add(TopGuesses *top, RankedGuess guess) {
+    if (top->count == TOP_GUESSES_CAPACITY) {
+        if (!RankedGuess_is_better(top->order, guess, top->guesses[TOP_GUESSES_CAPACITY - 1])) return;
+        top->count--;
+    }
+    size_t i = top->count++;
+    for (; i > 0 && RankedGuess_is_better(top->order, guess, top->guesses[i - 1]); i--) {
+        top->guesses[i] = top->guesses[i - 1];
+    }
+    top->guesses[i] = guess;
+}
+
+void TopGuesses_merge(TopGuesses *top, const TopGuesses *other) {
+    for (size_t i = 0; i < other->count; i++) {
+        TopGuesses_add(top, other->guesses[i]);
+    }
+}
+
+RankedGuess RankedGuess_select(RankingOrder order, RankedGuess *guesses, size_t count, size_t nth) {
+    // quickselect; guesses never compare equal, the word index decides last
+    ptrdiff_t low = 0, high = count - 1;
+    while (low < high) {
+        RankedGuess pivot = guesses[low + (high - low) / 2];
+        ptrdiff_t i = low, j = high;
+        while (i <= j) {
+            while (RankedGuess_is_better(order, guesses[i], pivot)) i++;
+            while (RankedGuess_is_better(order, pivot, guesses[j])) j--;
+            if (i <= j) {
+                RankedGuess swap = guesses[i];
+                guesses[i++] = guesses[j];
+                guesses[j--] = swap;
+            }
+        }
+        if ((ptrdiff_t) nth <= j) {
+            high = j;
+        } else if ((ptrdiff_t) nth >= i) {
+            low = i;
+        } else {
+            break;
+        }
+    }
+    return guesses[nth];
+}
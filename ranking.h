@@ -0,0 +1,45 @@
+#ifndef RANKING_H_
+#define RANKING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pattern.h"
+
+typedef struct {
+    WordIndex word;
+    bool is_candidate; // the guess may be the answer itself
+    uint64_t score;    // lower is better
+} RankedGuess;
+
+typedef enum {
+    RANK_BY_SCORE,         // candidates only win ties
+    RANK_CANDIDATES_FIRST, // any candidate beats any other guess
+} RankingOrder;
+
+// the lower word index decides last, so the order never depends on who scored what
+static inline bool RankedGuess_is_better(RankingOrder order, RankedGuess a, RankedGuess b) {
+    if (order == RANK_CANDIDATES_FIRST && a.is_candidate != b.is_candidate) return a.is_candidate;
+    if (a.score != b.score) return a.score < b.score;
+    if (a.is_candidate != b.is_candidate) return a.is_candidate;
+    return a.word < b.word;
+}
+
+#define TOP_GUESSES_CAPACITY 10
+
+// best guesses seen so far, best first
+typedef struct {
+    RankingOrder order;
+    RankedGuess guesses[TOP_GUESSES_CAPACITY];
+    size_t count;
+} TopGuesses;
+
+void TopGuesses_clear(TopGuesses *top, RankingOrder order);
+void TopGuesses_add(TopGuesses *top, RankedGuess guess);
+void TopGuesses_merge(TopGuesses *top, const TopGuesses *other);
+
+// the guess that would be at index nth if guesses were sorted best first; reorders guesses
+RankedGuess RankedGuess_select(RankingOrder order, RankedGuess *guesses, size_t count, size_t nth);
+
+#endif //RANKING_H_
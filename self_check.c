@@ -0,0 +1,203 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solver.h"
+#include "pattern.h"
+#include "kernels.h"
+#include "constraints.h"
+#include "words.c"
+
+static int report_mismatch(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+static size_t MISMATCHES = 0;
+
+// prints the first few mismatches, counts all of them
+static int report_mismatch(const char *format, ...) {
+    if (MISMATCHES++ >= 10) return 0;
+    va_list args;
+    va_start(args, format);
+    int result = vfprintf(stderr, format, args);
+    va_end(args);
+    return result;
+}
+
+
+
+// kernels
+// every kernel the CPU supports against generate_pattern, on every guess and answer of the dictionary
+static void check_kernels(void) {
+    // answers column-wise as in PatternMatrix_init, rows preceded by a header as in the matrix
+    size_t stride = (WORDS_COUNT + PATTERN_BATCH - 1) / PATTERN_BATCH * PATTERN_BATCH;
+    char *columns = calloc(WORD_LEN * stride, sizeof(char));
+    uint8_t *buffer = malloc(sizeof(PatternsFileHeader) + WORDS_COUNT * sizeof(Pattern));
+    Pattern *batch_row = malloc(stride * sizeof(Pattern));
+    WordIndex *all = malloc(WORDS_COUNT * sizeof(WordIndex));
+    WordIndex *expected = malloc(2 * WORDS_COUNT * sizeof(WordIndex));
+    WordIndex *kept = malloc(WORDS_COUNT * sizeof(WordIndex));
+    if (columns == NULL || buffer == NULL || batch_row == NULL || all == NULL || expected == NULL || kept == NULL) {
+        fprintf(stderr, "cannot allocate kernel check\n");
+        exit(-1);
+    }
+    Pattern *row = (Pattern*) (buffer + sizeof(PatternsFileHeader));
+    for (size_t j = 0; j < WORDS_COUNT; j++) {
+        for (int i = 0; i < WORD_LEN; i++) {
+            columns[i * stride + j] = WORDS[j].val[i];
+        }
+        all[j] = j;
+    }
+
+    const Kernels *levels[KERNELS_AVX512 + 1];
+    for (KernelsLevel level = KERNELS_SCALAR; level <= KERNELS_AVX512; level++) {
+        levels[level] = get_kernels_at(level);
+    }
+    for (WordIndex guess = 0; guess < WORDS_COUNT; guess++) {
+        uint32_t expected_counts[PATTERN_COUNT] = {0};
+        for (size_t j = 0; j < WORDS_COUNT; j++) {
+            row[j] = generate_pattern(WORDS[guess], WORDS[j]);
+            expected_counts[row[j]]++;
+        }
+        // all gray is the most common result, the other one depends on the guess
+        Pattern patterns[2] = { 0, row[WORDS_COUNT - 1 - guess] };
+        size_t expected_kept[2];
+        for (int p = 0; p < 2; p++) {
+            expected_kept[p] = 0;
+            for (size_t j = 0; j < WORDS_COUNT; j++) {
+                if (row[j] == patterns[p]) expected[p * WORDS_COUNT + expected_kept[p]++] = j;
+            }
+        }
+
+        for (KernelsLevel level = KERNELS_SCALAR; level <= KERNELS_AVX512; level++) {
+            const Kernels *kernels = levels[level];
+            if (kernels == NULL) continue;
+            for (size_t j = 0; j < stride; j += PATTERN_BATCH) {
+                kernels->feedback(WORDS[guess], columns + j, stride, batch_row + j);
+            }
+            for (size_t j = 0; j < WORDS_COUNT; j++) {
+                if (batch_row[j] != row[j]) {
+                    report_mismatch("%s feedback: %.*s against %.*s gives %d, not %d\n", kernels->name,
+                                    WORD_LEN, WORDS[guess].val, WORD_LEN, WORDS[j].val, batch_row[j], row[j]);
+                }
+            }
+
+            for (int p = 0; p < 2; p++) {
+                size_t count = kernels->filter(row, patterns[p], all, WORDS_COUNT, kept);
+                if (count != expected_kept[p]
+                        || memcmp(kept, expected + p * WORDS_COUNT, count * sizeof(WordIndex)) != 0) {
+                    report_mismatch("%s filter: %.*s keeps other words for %d\n", kernels->name,
+                                    WORD_LEN, WORDS[guess].val, patterns[p]);
+                }
+            }
+
+            uint32_t counts[PATTERN_COUNT] = {0};
+            kernels->histogram(row, all, WORDS_COUNT, counts);
+            if (memcmp(counts, expected_counts, sizeof(counts)) != 0) {
+                report_mismatch("%s histogram: %.*s gives other counts\n", kernels->name, WORD_LEN, WORDS[guess].val);
+            }
+        }
+    }
+
+    for (KernelsLevel level = KERNELS_SCALAR; level <= KERNELS_AVX512; level++) {
+        if (levels[level] != NULL) printf("%s kernels checked\n", levels[level]->name);
+    }
+    free(columns);
+    free(buffer);
+    free(batch_row);
+    free(all);
+    free(expected);
+    free(kept);
+}
+// kernels END
+
+
+
+// constraints
+#define HISTORIES_COUNT 1000
+#define HISTORIES_SEED 1
+#define HISTORY_PROBES_MAX 6 // a game rarely takes more
+
+// compiled constraints against the patterns every probe gives, on random histories of probes some answer gave
+static void check_constraints(void) {
+    srand(HISTORIES_SEED);
+    for (size_t history = 0; history < HISTORIES_COUNT; history++) {
+        Word answer = WORDS[rand() % WORDS_COUNT];
+        int probes_count = 1 + rand() % HISTORY_PROBES_MAX;
+        Word guesses[HISTORY_PROBES_MAX];
+        Pattern patterns[HISTORY_PROBES_MAX];
+        Constraints constraints;
+        Constraints_init(&constraints);
+        for (int i = 0; i < probes_count; i++) {
+            guesses[i] = WORDS[rand() % WORDS_COUNT];
+            patterns[i] = generate_pattern(guesses[i], answer);
+            Constraints_add_probe(&constraints, Word_pack(guesses[i]), patterns[i]);
+        }
+
+        for (size_t j = 0; j < WORDS_COUNT; j++) {
+            bool expected = true;
+            for (int i = 0; i < probes_count && expected; i++) {
+                expected = generate_pattern(guesses[i], WORDS[j]) == patterns[i];
+            }
+            if (Constraints_match(&constraints, Word_pack(WORDS[j])) != expected) {
+                report_mismatch("constraints: %.*s %s after %d probes of %.*s, the first being %.*s\n",
+                                WORD_LEN, WORDS[j].val, expected ? "dropped" : "kept", probes_count,
+                                WORD_LEN, answer.val, WORD_LEN, guesses[0].val);
+            }
+        }
+    }
+    printf("constraints checked on %d histories\n", HISTORIES_COUNT);
+}
+// constraints END
+
+
+
+// contexts
+#define CHECK_WORKERS 4
+
+static int quiet_printf(const char *restrict format, ...) {
+    (void)format;
+    return 0;
+}
+
+// a guess asked again without a new probe stays the same, and the same on the workers as without them
+static void check_repeated_guesses(void) {
+    const char *probes[][2] = { { "lares", "11111" }, { "fuzzy", "11111" } };
+    set_workers(CHECK_WORKERS, false);
+    SolverContext *on_workers = SolverContext_create(true);
+    SolverContext *serial = SolverContext_create(false);
+    for (size_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++) {
+        Probe probe = { .guess = Word_from_str(probes[i][0]), .result = Word_from_str(probes[i][1]) };
+        SolverContext_reset(on_workers);
+        SolverContext_reset(serial);
+        SolverContext_save_probe(on_workers, probe);
+        SolverContext_save_probe(serial, probe);
+        Word expected = SolverContext_guess_word(serial);
+        for (int repeat = 0; repeat < 2; repeat++) {
+            Word guess = SolverContext_guess_word(on_workers);
+            if (!Word_equals(guess, expected)) {
+                report_mismatch("contexts: %.*s after %s %s, asked %d times on %d workers, not %.*s\n",
+                                WORD_LEN, guess.val, probes[i][0], probes[i][1], repeat + 1, CHECK_WORKERS,
+                                WORD_LEN, expected.val);
+            }
+        }
+    }
+    SolverContext_destroy(on_workers);
+    SolverContext_destroy(serial);
+    printf("repeated guesses checked\n");
+}
+// contexts END
+
+
+
+// checks the optimized code against the plain one it replaces, exits with -1 on any mismatch
+int main(void) {
+    solver_printf = quiet_printf;
+    check_kernels();
+    check_constraints();
+    check_repeated_guesses();
+    if (MISMATCHES > 0) {
+        fprintf(stderr, "%zu mismatches\n", MISMATCHES);
+        return -1;
+    }
+    return 0;
+}
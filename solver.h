@@ -1,7 +1,9 @@
 #ifndef SOLVER_H_
 #define SOLVER_H_
 
+#include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #define WORD_LEN 5
 #define MAX_PROBES 128
@@ -33,6 +35,56 @@ Word generate_result(Word guess, Word actual);
 
 Word guess_word(void);
 
+// workers_count 0 sizes the pool from the available CPUs, pin keeps each worker on one CPU;
+// only takes effect before the first guess
+void set_workers(size_t workers_count, bool pin);
+
+// scores every guess on a random sample of sample_size candidates first, then only the best keep_fraction
+// of them, or those within margin of their score, on all candidates; keep_fraction is in (0, 1] and margin
+// at least 0, other values are ignored; sample_size 0 turns it off, which is the default
+// unless SOLVER_PRESCREEN is set; check also scores every guess on all candidates to count changed picks
+void set_prescreening(size_t sample_size, double keep_fraction, double margin, bool check);
+// turns played with prescreening so far, and the turns in which it changed the pick when checked
+void get_prescreening_stats(size_t *turns, size_t *changed_picks);
+
+// guesses splitting the candidates like another guess are not scored once few candidates are left;
+// turns played that way so far, the guesses they skipped for sharing no letter with the candidates,
+// and those they skipped for splitting them like an earlier guess
+void get_deduplication_stats(size_t *turns, size_t *uninformative_guesses, size_t *collapsed_guesses);
+
+// picks among the top_count best guesses the one whose results are split best by their own best next guess;
+// stops looking after budget_seconds per turn, 0 for no limit, which must be finite and at least 0 or it is
+// ignored; top_count 0 or 1 turns it off, which is the default unless SOLVER_LOOKAHEAD is set;
+// at most 10 guesses are looked into
+void set_lookahead(size_t top_count, double budget_seconds);
+
+// with max_candidates or fewer left, searches every guess for the least guesses to the answer on average
+// instead of scoring them; 0 turns it off, which is the default unless SOLVER_ENDGAME is set
+void set_endgame(size_t max_candidates);
+
+// frees the totals the end game searches remember; they are shared by all contexts and kept until then
+void reset_endgame(void);
+
+// looks every guess up in the tree file at path, written by generate_tree with the settings it should play by,
+// and only computes the guesses the probes lead off it; NULL computes them all, which is the default unless
+// SOLVER_TREE is set; only takes effect before the first guess
+void set_decision_tree(const char *path);
+// turns played from the tree so far, and the turns off it
+void get_decision_tree_stats(size_t *looked_up_turns, size_t *missed_turns);
+
+// a game of its own, any number of them can be played at once from any threads;
+// the dictionary and the pattern matrix are shared, and so are the workers: contexts using them
+// compute their guesses one at a time, the others compute them on the calling thread
+typedef struct SolverContext SolverContext;
+
+SolverContext* SolverContext_create(bool uses_workers);
+void SolverContext_reset(SolverContext *context);
+void SolverContext_destroy(SolverContext *context);
+
+void SolverContext_save_probe(SolverContext *context, Probe probe);
+int SolverContext_get_probes_count(const SolverContext *context);
+Word SolverContext_guess_word(SolverContext *context);
+
 extern int (*solver_printf)(const char *restrict format, ...);
 
 #endif //SOLVER_H_ 
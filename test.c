@@ -1,17 +1,25 @@
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 #include "solver.h"
+#include "pattern.h"
+#include "partition.h"
+#include "pool.h"
+#include "engine.h"
 #include "words.c"
 
-int test_wordle(Word wordle) {
-    reset_probes();
-    while (get_probes_count() < MAX_PROBES) {
-        Word guess = guess_word();
+int test_wordle(SolverContext *context, Word wordle) {
+    SolverContext_reset(context);
+    while (SolverContext_get_probes_count(context) < MAX_PROBES) {
+        Word guess = SolverContext_guess_word(context);
         if (Word_equals(wordle, guess)) {
-            return get_probes_count() + 1;
+            return SolverContext_get_probes_count(context) + 1;
         }
         Word result = generate_result(guess, wordle);
-        save_probe((Probe) { .guess = guess, .result = result });
+        SolverContext_save_probe(context, (Probe) { .guess = guess, .result = result });
     }
     return -1;
 }
@@ -21,14 +29,168 @@ int test_solver_printf(const char *restrict format, ...) {
     return 0;
 }
 
-int main(void) {
+
+
+// parallel games: every thread plays the next game nobody took yet with a context of its own
+static int PROBES[WORDS_COUNT];
+static _Atomic size_t NEXT_WORDLE = 0;
+
+static void* games_routine(void* arg) {
+    (void)arg;
+    SolverContext *context = SolverContext_create(false);
+    size_t i;
+    while ((i = atomic_fetch_add(&NEXT_WORDLE, 1)) < WORDS_COUNT) {
+        PROBES[i] = test_wordle(context, WORDS[i]);
+    }
+    SolverContext_destroy(context);
+    return NULL;
+}
+
+static void play_games(size_t threads_count) {
+    if (threads_count == 0) {
+        // one game after another, each guess on all workers
+        SolverContext *context = SolverContext_create(true);
+        for (size_t i = 0; i < WORDS_COUNT; i++) {
+            PROBES[i] = test_wordle(context, WORDS[i]);
+        }
+        SolverContext_destroy(context);
+        return;
+    }
+    pthread_t threads[threads_count];
+    for (size_t i = 0; i < threads_count; i++) {
+        if (pthread_create(threads + i, NULL, games_routine, NULL) != 0) {
+            fprintf(stderr, "cannot create game thread\n");
+            exit(-1);
+        }
+    }
+    for (size_t i = 0; i < threads_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+// parallel games END
+
+
+
+// tree of games: the answers that got the same results so far share every guess, so each guess is computed once;
+// threads take the subtrees below the opener one by one
+static Word ROOT_GUESS;
+static WordIndex ROOT_ANSWERS[WORDS_COUNT];
+static size_t ROOT_OFFSETS[PATTERN_COUNT + 1];
+static _Atomic size_t NEXT_ROOT_PATTERN = 0;
+
+static void walk_tree(SolverContext *context, Probe *probes, int probes_count, const WordIndex *answers, size_t count);
+
+// the answers below guess: guessed now, or played on with the result they give
+static void walk_children(SolverContext *context, Probe *probes, int probes_count, Word guess,
+                          const WordIndex *sorted, const size_t offsets[PATTERN_COUNT + 1], size_t pattern) {
+    size_t from = offsets[pattern], to = offsets[pattern + 1];
+    if (from == to) return;
+    if (pattern == PATTERN_ALL_GREEN) {
+        PROBES[sorted[from]] = probes_count + 1;
+        return;
+    }
+    probes[probes_count] = (Probe) { .guess = guess, .result = Pattern_to_result(pattern) };
+    walk_tree(context, probes, probes_count + 1, sorted + from, to - from);
+}
+
+static void walk_tree(SolverContext *context, Probe *probes, int probes_count, const WordIndex *answers, size_t count) {
+    if (probes_count >= MAX_PROBES) {
+        for (size_t i = 0; i < count; i++) {
+            PROBES[answers[i]] = -1;
+        }
+        return;
+    }
+    SolverContext_reset(context);
+    for (int i = 0; i < probes_count; i++) {
+        SolverContext_save_probe(context, probes[i]);
+    }
+    Word guess = SolverContext_guess_word(context);
+
+    WordIndex *sorted = malloc(count * sizeof(WordIndex));
+    if (sorted == NULL) {
+        fprintf(stderr, "cannot allocate answers\n");
+        exit(-1);
+    }
+    size_t offsets[PATTERN_COUNT + 1];
+    Partition_sort(get_pattern_matrix(), find_word_index(guess), answers, count, sorted, offsets);
+    for (size_t p = 0; p < PATTERN_COUNT; p++) {
+        walk_children(context, probes, probes_count, guess, sorted, offsets, p);
+    }
+    free(sorted);
+}
+
+static void* tree_routine(void* arg) {
+    SolverContext *context = SolverContext_create(arg != NULL);
+    Probe probes[MAX_PROBES];
+    size_t p;
+    while ((p = atomic_fetch_add(&NEXT_ROOT_PATTERN, 1)) < PATTERN_COUNT) {
+        walk_children(context, probes, 0, ROOT_GUESS, ROOT_ANSWERS, ROOT_OFFSETS, p);
+    }
+    SolverContext_destroy(context);
+    return NULL;
+}
+
+static void play_tree(size_t threads_count) {
+    SolverContext *context = SolverContext_create(false);
+    ROOT_GUESS = SolverContext_guess_word(context);
+    SolverContext_destroy(context);
+    WordIndex all[WORDS_COUNT];
+    for (size_t i = 0; i < WORDS_COUNT; i++) {
+        all[i] = i;
+    }
+    Partition_sort(get_pattern_matrix(), find_word_index(ROOT_GUESS), all, WORDS_COUNT, ROOT_ANSWERS, ROOT_OFFSETS);
+
+    if (threads_count == 0) {
+        tree_routine(&threads_count); // any non NULL argument: guesses on all workers
+        return;
+    }
+    pthread_t threads[threads_count];
+    for (size_t i = 0; i < threads_count; i++) {
+        if (pthread_create(threads + i, NULL, tree_routine, NULL) != 0) {
+            fprintf(stderr, "cannot create game thread\n");
+            exit(-1);
+        }
+    }
+    for (size_t i = 0; i < threads_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+// tree of games END
+
+
+
+// -j N plays N games at once, -j 0 one per CPU; without it games are played one by one;
+// -t plays all games as one tree, with -j the subtrees are shared out to threads the same way
+int main(int argc, char **argv) {
     solver_printf = test_solver_printf;
-    bool were_errors = false;
+    size_t threads_count = 0;
+    bool as_tree = false;
+    int option;
+    while ((option = getopt(argc, argv, "j:t")) != -1) {
+        if (option == 't') {
+            as_tree = true;
+        } else if (option == 'j') {
+            long count = atol(optarg);
+            threads_count = count > 0 ? (size_t) count : available_cpus_count();
+        } else {
+            fprintf(stderr, "usage: %s [-j games_at_once] [-t]\n", argv[0]);
+            return -1;
+        }
+    }
 
+    double started = seconds_now();
+    if (as_tree) {
+        play_tree(threads_count);
+    } else {
+        play_games(threads_count);
+    }
+    double elapsed = seconds_now() - started;
+
+    bool were_errors = false;
     puts("[");
     for (size_t i = 0; i < WORDS_COUNT; i++) {
         Word wordle = WORDS[i];
-        int probes = test_wordle(wordle);
+        int probes = PROBES[i];
         if (probes <= 0) {
             were_errors = true;
         }
@@ -36,6 +198,21 @@ int main(void) {
         printf("    { \"wordle\": \"%.5s\", \"probes\": %d }%s\n", wordle.val, probes, is_last ? "" : ",");
     }
     puts("]");
+    fprintf(stderr, "%zu games in %.1f s, %.1f games/s\n", (size_t) WORDS_COUNT, elapsed, WORDS_COUNT / elapsed);
+    size_t prescreened_turns, changed_picks;
+    get_prescreening_stats(&prescreened_turns, &changed_picks);
+    if (prescreened_turns > 0) {
+        fprintf(stderr, "%zu turns prescreened, %zu changed picks\n", prescreened_turns, changed_picks);
+    }
+    size_t looked_up_turns, missed_turns;
+    get_decision_tree_stats(&looked_up_turns, &missed_turns);
+    if (looked_up_turns + missed_turns > 0) {
+        fprintf(stderr, "%zu turns looked up, %zu off the tree\n", looked_up_turns, missed_turns);
+    }
+    size_t deduplicated_turns, uninformative_guesses, collapsed_guesses;
+    get_deduplication_stats(&deduplicated_turns, &uninformative_guesses, &collapsed_guesses);
+    fprintf(stderr, "%zu turns deduplicated, %zu uninformative guesses dropped, %zu guesses collapsed\n",
+            deduplicated_turns, uninformative_guesses, collapsed_guesses);
 
     if (were_errors) {
         fprintf(stderr, "Some tests failed!\n");
@@ -43,4 +220,3 @@ int main(void) {
     }
     return 0;
 }
-
@@ -0,0 +1,225 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tree.h"
+
+uint32_t DecisionTree_child(const DecisionTree *tree, uint32_t node, Pattern pattern) {
+    uint32_t from = tree->first_edges[node], to = tree->first_edges[node + 1];
+    while (from < to) {
+        uint32_t middle = from + (to - from) / 2;
+        if (tree->patterns[middle] < pattern) {
+            from = middle + 1;
+        } else {
+            to = middle;
+        }
+    }
+    if (from == tree->first_edges[node + 1] || tree->patterns[from] != pattern) return NO_TREE_NODE;
+    return tree->children[from];
+}
+
+static size_t tree_file_size(size_t nodes_count, size_t edges_count) {
+    return sizeof(TreeFileHeader) + nodes_count * sizeof(WordIndex) + (nodes_count + 1) * sizeof(uint32_t)
+           + edges_count * (sizeof(uint32_t) + sizeof(Pattern));
+}
+
+// a broken file must not send a walk out of the arrays
+static bool DecisionTree_is_consistent(const DecisionTree *tree, size_t words_count) {
+    if (tree->nodes_count == 0 || tree->first_edges[0] != 0
+            || tree->first_edges[tree->nodes_count] != tree->edges_count) {
+        return false;
+    }
+    for (size_t i = 0; i < tree->nodes_count; i++) {
+        if (tree->guesses[i] >= words_count || tree->first_edges[i] > tree->first_edges[i + 1]) return false;
+    }
+    for (size_t i = 0; i < tree->edges_count; i++) {
+        if (tree->children[i] >= tree->nodes_count || tree->patterns[i] >= PATTERN_ALL_GREEN) return false;
+    }
+    return true;
+}
+
+static bool TreeSettings_equals(const TreeSettings *a, const TreeSettings *b) {
+    return a->prescreen_sample == b->prescreen_sample && a->prescreen_keep == b->prescreen_keep
+           && a->prescreen_margin == b->prescreen_margin && a->lookahead_top == b->lookahead_top
+           && a->lookahead_budget == b->lookahead_budget && a->endgame_max == b->endgame_max;
+}
+
+bool DecisionTree_load(DecisionTree *tree, const char *path, const char *solver_name, const TreeSettings *settings,
+                       const Word *words, size_t words_count) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(TreeFileHeader)) {
+        fprintf(stderr, "%s: unexpected size, ignoring it\n", path);
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "%s: cannot mmap, ignoring it\n", path);
+        return false;
+    }
+
+    const TreeFileHeader *header = mapping;
+    if (memcmp(header->magic, TREE_FILE_MAGIC, sizeof(header->magic)) != 0
+            || header->encoding_version != PATTERN_ENCODING_VERSION
+            || header->words_count != words_count
+            || header->words_checksum != words_checksum(words, words_count)
+            || strncmp(header->solver_name, solver_name, TREE_SOLVER_NAME_LEN) != 0) {
+        fprintf(stderr, "%s: stale or foreign tree file, ignoring it\n", path);
+        munmap(mapping, size);
+        return false;
+    }
+    if (!TreeSettings_equals(&header->settings, settings)) {
+        fprintf(stderr, "%s: expanded with other SOLVER_* settings, ignoring it\n", path);
+        munmap(mapping, size);
+        return false;
+    }
+    if (size != tree_file_size(header->nodes_count, header->edges_count)) {
+        fprintf(stderr, "%s: unexpected size, ignoring it\n", path);
+        munmap(mapping, size);
+        return false;
+    }
+
+    tree->nodes_count = header->nodes_count;
+    tree->edges_count = header->edges_count;
+    tree->guesses = (const WordIndex*) (header + 1);
+    tree->first_edges = (const uint32_t*) (tree->guesses + tree->nodes_count);
+    tree->children = tree->first_edges + tree->nodes_count + 1;
+    tree->patterns = (const Pattern*) (tree->children + tree->edges_count);
+    if (!DecisionTree_is_consistent(tree, words_count)) {
+        fprintf(stderr, "%s: broken tree file, ignoring it\n", path);
+        munmap(mapping, size);
+        return false;
+    }
+    return true;
+}
+
+
+
+// tree building
+static void* checked_realloc(void *pointer, size_t size) {
+    void *result = realloc(pointer, size);
+    if (result == NULL) {
+        fprintf(stderr, "cannot allocate decision tree\n");
+        exit(-1);
+    }
+    return result;
+}
+
+void TreeBuilder_init(TreeBuilder *builder) {
+    *builder = (TreeBuilder) {0};
+    // the extra first edge closing the last node is always there
+    builder->first_edges = checked_realloc(NULL, sizeof(uint32_t));
+    builder->first_edges[0] = 0;
+}
+
+void TreeBuilder_free(TreeBuilder *builder) {
+    free(builder->guesses);
+    free(builder->first_edges);
+    free(builder->children);
+    free(builder->patterns);
+    *builder = (TreeBuilder) {0};
+}
+
+static void reserve(TreeBuilder *builder, size_t nodes_count, size_t edges_count) {
+    if (nodes_count > builder->nodes_capacity) {
+        size_t capacity = builder->nodes_capacity > 0 ? builder->nodes_capacity : 256;
+        while (capacity < nodes_count) {
+            capacity *= 2;
+        }
+        builder->guesses = checked_realloc(builder->guesses, capacity * sizeof(WordIndex));
+        builder->first_edges = checked_realloc(builder->first_edges, (capacity + 1) * sizeof(uint32_t));
+        builder->nodes_capacity = capacity;
+    }
+    if (edges_count > builder->edges_capacity) {
+        size_t capacity = builder->edges_capacity > 0 ? builder->edges_capacity : 1024;
+        while (capacity < edges_count) {
+            capacity *= 2;
+        }
+        builder->children = checked_realloc(builder->children, capacity * sizeof(uint32_t));
+        builder->patterns = checked_realloc(builder->patterns, capacity * sizeof(Pattern));
+        builder->edges_capacity = capacity;
+    }
+}
+
+uint32_t TreeBuilder_add_node(TreeBuilder *builder, WordIndex guess, size_t edges_count) {
+    reserve(builder, builder->nodes_count + 1, builder->edges_count + edges_count);
+    uint32_t node = builder->nodes_count++;
+    builder->guesses[node] = guess;
+    for (size_t i = 0; i < edges_count; i++) {
+        builder->children[builder->edges_count + i] = NO_TREE_NODE;
+    }
+    builder->edges_count += edges_count;
+    builder->first_edges[node + 1] = builder->edges_count;
+    return node;
+}
+
+void TreeBuilder_set_edge(TreeBuilder *builder, uint32_t node, size_t edge, Pattern pattern, uint32_t child) {
+    size_t i = builder->first_edges[node] + edge;
+    builder->patterns[i] = pattern;
+    builder->children[i] = child;
+}
+
+uint32_t TreeBuilder_append(TreeBuilder *builder, const TreeBuilder *subtree) {
+    uint32_t node_offset = builder->nodes_count, edge_offset = builder->edges_count;
+    reserve(builder, node_offset + subtree->nodes_count, edge_offset + subtree->edges_count);
+    for (size_t i = 0; i < subtree->nodes_count; i++) {
+        builder->guesses[node_offset + i] = subtree->guesses[i];
+        builder->first_edges[node_offset + i + 1] = edge_offset + subtree->first_edges[i + 1];
+    }
+    for (size_t i = 0; i < subtree->edges_count; i++) {
+        builder->children[edge_offset + i] = node_offset + subtree->children[i];
+        builder->patterns[edge_offset + i] = subtree->patterns[i];
+    }
+    builder->nodes_count += subtree->nodes_count;
+    builder->edges_count += subtree->edges_count;
+    return node_offset;
+}
+
+void TreeBuilder_save(const TreeBuilder *builder, const char *path, const char *solver_name,
+                      const TreeSettings *settings, const Word *words, size_t words_count) {
+    TreeFileHeader header = {
+        .encoding_version = PATTERN_ENCODING_VERSION,
+        .words_count = words_count,
+        .words_checksum = words_checksum(words, words_count),
+        .nodes_count = builder->nodes_count,
+        .edges_count = builder->edges_count,
+        .settings = *settings,
+    };
+    memcpy(header.magic, TREE_FILE_MAGIC, sizeof(header.magic));
+    memcpy(header.solver_name, solver_name, strnlen(solver_name, TREE_SOLVER_NAME_LEN - 1));
+
+    // written aside and renamed like the pattern file
+    char tmp_path[strlen(path) + sizeof(".tmp")];
+    sprintf(tmp_path, "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "cannot open %s\n", tmp_path);
+        exit(-1);
+    }
+    size_t nodes_count = builder->nodes_count, edges_count = builder->edges_count;
+    if (fwrite(&header, sizeof(header), 1, file) != 1
+            || fwrite(builder->guesses, sizeof(WordIndex), nodes_count, file) != nodes_count
+            || fwrite(builder->first_edges, sizeof(uint32_t), nodes_count + 1, file) != nodes_count + 1
+            || fwrite(builder->children, sizeof(uint32_t), edges_count, file) != edges_count
+            || fwrite(builder->patterns, sizeof(Pattern), edges_count, file) != edges_count
+            || fclose(file) != 0) {
+        fprintf(stderr, "cannot write %s\n", tmp_path);
+        exit(-1);
+    }
+    if (rename(tmp_path, path) != 0) {
+        fprintf(stderr, "cannot rename %s to %s\n", tmp_path, path);
+        exit(-1);
+    }
+}
+// tree building END
@@ -0,0 +1,78 @@
+#ifndef TREE_H_
+#define TREE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pattern.h"
+
+// every guess of a solver from the opener on: a node holds the guess made after the results leading to it,
+// its edges the results other than all green that some answer gives, in ascending order; node 0 is the opener
+typedef struct {
+    const WordIndex *guesses;     // per node
+    const uint32_t *first_edges;  // per node and one more, the edges of node i are first_edges[i] .. first_edges[i + 1]
+    const uint32_t *children;     // per edge, the node reached by its result
+    const Pattern *patterns;      // per edge
+    size_t nodes_count;
+    size_t edges_count;
+} DecisionTree;
+
+#define NO_TREE_NODE (~(uint32_t)(0))
+
+// on-disk tree: the header is followed by the guesses, first_edges, children and patterns arrays
+#define TREE_FILE_MAGIC "WRDLTREE"
+#define TREE_SOLVER_NAME_LEN 16
+
+// the SOLVER_* settings the guesses were chosen with, all 0 for those that are off
+typedef struct {
+    uint32_t prescreen_sample;
+    uint32_t lookahead_top;
+    double prescreen_keep;
+    double prescreen_margin;
+    double lookahead_budget;
+    uint32_t endgame_max;
+    uint32_t reserved;
+} TreeSettings;
+
+typedef struct {
+    char magic[8];
+    uint32_t encoding_version; // PATTERN_ENCODING_VERSION
+    uint32_t words_count;
+    uint64_t words_checksum;
+    uint32_t nodes_count;
+    uint32_t edges_count;
+    char solver_name[TREE_SOLVER_NAME_LEN]; // trees of a solver are not walked by another one
+    TreeSettings settings;                  // nor with other settings
+    uint8_t reserved[40];
+} TreeFileHeader;
+
+// the node reached from node by the result pattern, NO_TREE_NODE when no answer gives it
+uint32_t DecisionTree_child(const DecisionTree *tree, uint32_t node, Pattern pattern);
+
+// maps the file, false if it is missing, stale, of another solver or other settings, or broken
+bool DecisionTree_load(DecisionTree *tree, const char *path, const char *solver_name, const TreeSettings *settings,
+                       const Word *words, size_t words_count);
+
+// tree under construction, nodes are added depth first: the edges of a node are reserved when it is added
+// and get their children once these are added
+typedef struct {
+    WordIndex *guesses;
+    uint32_t *first_edges;
+    uint32_t *children;
+    Pattern *patterns;
+    size_t nodes_count, nodes_capacity;
+    size_t edges_count, edges_capacity;
+} TreeBuilder;
+
+void TreeBuilder_init(TreeBuilder *builder);
+void TreeBuilder_free(TreeBuilder *builder);
+// returns the new node, its edges are first_edges[node] + 0 .. edges_count - 1
+uint32_t TreeBuilder_add_node(TreeBuilder *builder, WordIndex guess, size_t edges_count);
+void TreeBuilder_set_edge(TreeBuilder *builder, uint32_t node, size_t edge, Pattern pattern, uint32_t child);
+// copies all nodes of subtree after those of builder, returns where its node 0 went
+uint32_t TreeBuilder_append(TreeBuilder *builder, const TreeBuilder *subtree);
+void TreeBuilder_save(const TreeBuilder *builder, const char *path, const char *solver_name,
+                      const TreeSettings *settings, const Word *words, size_t words_count);
+
+#endif //TREE_H_